@@ -0,0 +1,45 @@
+#include "che_io.h"
+#include "che_bin.h"
+
+#include <cstdio>
+
+int main(int nargs, const char ** args)
+{
+	if(nargs < 3)
+	{
+		printf("./che_convert [input mesh path] [output .che path] [reorder = none | toplesets | morton | hilbert]\n");
+		return 0;
+	}
+
+	che * mesh = load_mesh(args[1]);
+	if(!mesh->n_vertices())
+	{
+		fprintf(stderr, "could not read %s\n", args[1]);
+		delete mesh;
+		return 1;
+	}
+
+	if(nargs > 3)
+	{
+		string order = args[3];
+		index_t * perm = NULL;
+
+		if(order == "toplesets") perm = mesh->reorder(che::TOPLESETS);
+		if(order == "morton") perm = mesh->reorder(che::MORTON);
+		if(order == "hilbert") perm = mesh->reorder(che::HILBERT);
+
+		delete [] perm;
+	}
+
+	bool written = che_bin::write_file(mesh, args[2]);
+	delete mesh;
+
+	if(!written)
+	{
+		fprintf(stderr, "could not write %s\n", args[2]);
+		return 1;
+	}
+
+	return 0;
+}
+
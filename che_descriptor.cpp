@@ -0,0 +1,37 @@
+#include "che_io.h"
+#include "descriptor.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int nargs, const char ** args)
+{
+	if(nargs < 4)
+	{
+		printf("./che_descriptor [input mesh path] [output path] [gps | hks | wks] [K = 100] [T = 100]\n");
+		return 0;
+	}
+
+	string sig = args[3];
+	size_t K = nargs > 4 ? atoi(args[4]) : 100;
+	size_t T = nargs > 5 ? atoi(args[5]) : 100;
+
+	descriptor::signature s = descriptor::HKS;
+	if(sig == "gps") s = descriptor::GPS;
+	if(sig == "wks") s = descriptor::WKS;
+
+	che * mesh = load_mesh(args[1]);
+
+	descriptor features(s, mesh, K, T);
+	if(!features || !features.save(args[2]))
+	{
+		printf("%s: error computing the descriptor\n", args[1]);
+		delete mesh;
+		return 1;
+	}
+
+	delete mesh;
+
+	return 0;
+}
+
@@ -4,7 +4,12 @@
 #include "viewer/viewer.h"
 #include "include.h"
 #include "che_off.h"
+#include "che_bin.h"
+#include "che_ply.h"
+#include "che_obj.h"
+#include "che_io.h"
 #include "laplacian.h"
+#include "descriptor.h"
 #include "che_off.h"
 #include "dijkstra.h"
 #include "geodesics.h"
@@ -43,6 +48,7 @@ void viewer_process_inpaiting();
 void viewer_process_iterative_inpaiting();
 
 void viewer_process_functional_maps();
+void viewer_process_descriptor(const descriptor::signature & sig);
 void viewer_process_gps();
 void viewer_process_hks();
 void viewer_process_wks();
@@ -20,12 +20,19 @@ index_t next(const index_t & he);
 index_t prev(const index_t & he);
 
 struct corr_t;
+struct che_corners;
+class heat_flow_solver;
 
 class che
 {
 	public:
 		static const size_t P = 3;
 
+		enum order_t {	TOPLESETS,		///< Breadth-first order (toplesets) of each connected component.
+						MORTON,			///< Morton order (Z curve) of the vertex positions.
+						HILBERT			///< Hilbert curve order of the vertex positions.
+						};
+
 	protected:
 		string filename_;
 
@@ -45,6 +52,9 @@ class che
 
 		bool manifold;
 
+		che_corners * corners_ = NULL;	///< Cache of the geometry of the corners, see corners().
+		heat_flow_solver * heat_solver_ = NULL;	///< Cache of the heat method factorizations, see heat_solver().
+
 	public:
 		virtual ~che();
 		void star(star_t & s, const index_t & v);
@@ -89,7 +99,10 @@ class che
 		const size_t & n_edges() const;
 		const size_t & n_borders() const;
 		size_t max_degree() const;
+		/// Writable vertex, call update_geometry after the writes, use gt to read.
 		vertex & get_vertex(index_t v);
+		/// Drops the caches of the geometry (corners, heat flow) after writing vertices with get_vertex.
+		void update_geometry();
 		void set_vertices(const vertex *const& positions, size_t n = 0, const index_t & v_i = 0);
 		void set_filename(const string & f);
 		const string & filename() const;
@@ -102,18 +115,27 @@ class che
 		void remove_non_manifold_vertices();
 		void remove_vertices(const vector<index_t> & vertices);
 		void merge(const che * mesh, const vector<index_t> & com_vertices);
+		void merge(che * const * meshes, const vector<index_t> * com_vertices, const size_t & n_meshes);
 		void set_head_vertices(index_t * head, const size_t & n);
+		index_t * reorder(const order_t & order = HILBERT);
 		index_t link_intersect(const index_t & v_a, const index_t & v_b);
 		corr_t * edge_collapse(const index_t *const & sort_edges, const vertex *const & normals);
 		corr_t find_corr(const vertex & v, const vertex & n, const vector<index_t> & triangles);
+		const che_corners & corners();
+		/// Heat method solver of the mesh, factorized on the first call and dropped with the corners.
+		heat_flow_solver & heat_solver();
 
 	protected:
-		void delete_me();
+		virtual void delete_me();
+		void delete_caches();
 		void init(const vertex * vertices, const index_t & n_v, const index_t * faces, const index_t & n_f);
 		void init(const string & file);
 		void init(const size_t & n_v, const size_t & n_f);
 		virtual void read_file(const string & file) = 0;
 
+		/// True if read_file loads the topology tables, then init does not rebuild them.
+		virtual bool loads_topology() const;
+
 	public:
 		virtual void write_file(const string & file) const = 0;
 
@@ -123,6 +145,7 @@ class che
 		void update_bt();
 
 	friend struct CHE;
+	friend class che_bin;
 };
 
 struct vertex_cu;
@@ -0,0 +1,59 @@
+#ifndef CHE_BIN_H
+#define CHE_BIN_H
+
+#include "che.h"
+
+#include <cstdint>
+
+/*!
+	Binary CHE file format. The file stores the tables GT, VT, OT, EVT, ET, EHT and BT in aligned
+	sections, then a mesh is opened with mmap and used directly, without parsing or rebuilding the
+	topology. The mapping is private (copy on write), modifications never change the file.
+	The header and the bounds of the tables are validated before mapping them, a file that is not
+	valid is reported and opened as an empty mesh (n_vertices() == 0).
+*/
+class che_bin : public che
+{
+	public:
+		static const size_t ALIGN = 64;		///< Alignment in bytes of each table in the file.
+		static const uint32_t VERSION = 2;
+
+	private:
+		struct header_t
+		{
+			char magic[4];					///< "CHEB".
+			uint32_t version;
+			uint32_t real_size;				///< sizeof(real_t), depends on SINGLE_P.
+			uint32_t index_size;			///< sizeof(index_t).
+			uint32_t manifold;
+			uint64_t n_vertices;
+			uint64_t n_faces;
+			uint64_t n_half_edges;
+			uint64_t n_edges;
+			uint64_t n_borders;
+			uint64_t offset[7];				///< GT, VT, OT, EVT, ET, EHT, BT.
+		};
+
+		char * mapped;						///< Mapped file, NULL if the tables are allocated.
+		size_t mapped_size;
+
+	public:
+		che_bin(const size_t & n_v = 0, const size_t & n_f = 0);
+		che_bin(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f);
+		che_bin(const string & file);
+		virtual ~che_bin();
+		void write_file(const string & file) const;
+
+		/// Save the tables of any mesh (che_off, che_bin, ...) in the binary CHE format,
+		/// returns false if the file could not be written.
+		static bool write_file(const che * mesh, const string & file);
+
+	private:
+		void read_file(const string & file);
+		bool loads_topology() const;
+		void delete_me();
+		void unmap();
+};
+
+#endif // CHE_BIN_H
+
@@ -0,0 +1,36 @@
+#ifndef CHE_CORNERS_H
+#define CHE_CORNERS_H
+
+#include "che.h"
+
+/*!
+	Geometry of the corners of a mesh. It depends only on GT, then it is computed once by
+	che::corners() and reused by the eikonal solvers (FM, PTP, see update_star) and by the heat flow
+	divergence, until che::set_vertices, che::normalize, che::update_geometry (after writes with
+	che::get_vertex) or a change of the tables invalidates it. A reference returned by corners()
+	is valid until one of those, which must not run while other threads use it.
+
+	In the order of for_star, for the corner of the half-edge he of the star of v:
+	X0 = gt(vt(next(he))) - gt(v), X1 = gt(vt(prev(he))) - gt(v) and Q is the inverse of the metric
+	X^T X. The arrays are in SoA layout, with the precision of real_t.
+*/
+struct che_corners
+{
+	size_t n_vertices;
+	index_t * begin;				///< Corners of the star of v in [begin[v], begin[v + 1]).
+	index_t * x0;					///< vt(next(he)).
+	index_t * x1;					///< vt(prev(he)).
+	real_t * Q00;
+	real_t * Q01;
+	real_t * Q11;
+	real_t * n0;					///< |X0|.
+	real_t * n1;					///< |X1|.
+
+	vertex * w;						///< By half-edge: normal_he(he) * (gt(vt(prev(he))) - gt(vt(next(he)))).
+
+	che_corners(const che * mesh);
+	~che_corners();
+};
+
+#endif // CHE_CORNERS_H
+
@@ -0,0 +1,10 @@
+#ifndef CHE_IO_H
+#define CHE_IO_H
+
+#include "che.h"
+
+/// Opens the mesh with the reader of the file extension: .che (che_bin), .ply, .obj, otherwise .off.
+che * load_mesh(const string & file);
+
+#endif // CHE_IO_H
+
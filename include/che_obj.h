@@ -0,0 +1,25 @@
+#ifndef CHE_OBJ_H
+#define CHE_OBJ_H
+
+#include "che.h"
+
+/*!
+	Wavefront OBJ file format. Only the vertices (v) and faces (f) are read, texture and normal indices
+	are ignored, negative (relative) indices are supported and polygons are divided in triangles like
+	in che_off.
+*/
+class che_obj : public che
+{
+	public:
+		che_obj(const size_t & n_v = 0, const size_t & n_f = 0);
+		che_obj(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f);
+		che_obj(const string & file);
+		virtual ~che_obj();
+		void write_file(const string & file) const;
+
+	private:
+		void read_file(const string & file);
+};
+
+#endif // CHE_OBJ_H
+
@@ -0,0 +1,24 @@
+#ifndef CHE_PLY_H
+#define CHE_PLY_H
+
+#include "che.h"
+
+/*!
+	PLY file format, ascii and binary (little and big endian). Only the vertex coordinates and the
+	vertex indices of the faces are read, polygons are divided in triangles like in che_off.
+*/
+class che_ply : public che
+{
+	public:
+		che_ply(const size_t & n_v = 0, const size_t & n_f = 0);
+		che_ply(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f);
+		che_ply(const string & file);
+		virtual ~che_ply();
+		void write_file(const string & file) const;
+
+	private:
+		void read_file(const string & file);
+};
+
+#endif // CHE_PLY_H
+
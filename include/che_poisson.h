@@ -2,13 +2,70 @@
 #define CHE_POISSON_H
 
 #include "che.h"
+#include "include_arma.h"
+
+#include <cholmod.h>
+#include <unordered_map>
 
 /**
 	Solve (-1)^k L(AL)^(k-1) X = (-1)^k A^(-1) B
+	for the new vertices [old_n_vertices, n_vertices), with a matrix free preconditioned conjugate
+	gradient: the operator is applied as k products with L, and the preconditioner uses the
+	cholmod factorization of the block of L of the new vertices.
+*/
+void poisson(che * mesh, const size_t & old_n_vertices, index_t k, const real_t & tol = 1e-8, const size_t & max_iter = 1000);
+
+/**
+	Same system of poisson, assembled and solved only on the rings 0..k of the new vertices
+	(compute_toplesets), then the cost depends on the size of the holes and not of the mesh.
+*/
+void poisson_local(che * mesh, const size_t & old_n_vertices, index_t k, const real_t & tol = 1e-8, const size_t & max_iter = 1000);
+
+/*!
+	Radial basis spline z(x, y) interpolating the heights P(2, i) at the centers (P(0, i), P(1, i)).
+	The system is assembled in parallel and factorized once, fit solves new heights with the same
+	factorization and eval evaluates a 3 x m matrix of points in parallel.
+	With radio = 0 it is the thin-plate spline r^2 (log r - 1), a dense system and O(n) per point;
+	with radio > 0 it is the compactly supported Wendland spline (1 - r / radio)^4 (4 r / radio + 1),
+	a sparse positive definite system (cholmod) and a grid of cells of size radio to evaluate only
+	the centers in the support, then it scales to holes with thousands of boundary vertices. The
+	Wendland spline goes to the mean height at a distance larger than radio from the centers.
 */
-void poisson(che * mesh, const size_t & old_n_vertices, index_t k);
+class biharmonic_spline_2
+{
+	private:
+		a_mat P;						///< 2 x n centers.
+		a_vec alpha;					///< weights of the centers.
+		real_t radio;
+		real_t z_mean;
+		a_mat L, U, Pr;					///< lu factors of the thin-plate system.
+		cholmod_common context;
+		cholmod_factor * F = NULL;		///< factorization of the Wendland system.
+		unordered_map<uint64_t, vector<index_t> > grid;
+
+	public:
+		biharmonic_spline_2(const a_mat & P, const real_t & radio = 0);
+		virtual ~biharmonic_spline_2();
+		biharmonic_spline_2(const biharmonic_spline_2 &) = delete;				///< owns the cholmod context and factor.
+		biharmonic_spline_2 & operator=(const biharmonic_spline_2 &) = delete;
+
+		/// Solves the weights for the heights z of the centers.
+		void fit(const a_vec & z);
+
+		/// H(2, i) = z(H(0, i), H(1, i)).
+		void eval(a_mat & H) const;
+
+	private:
+		real_t kernel(const real_t & r) const;
+		uint64_t cell(const real_t & x, const real_t & y) const;
+		void support(vector<index_t> & centers, const real_t & x, const real_t & y) const;
+};
+
+void biharmonic_interp_2(a_mat & P, a_mat & H, const real_t & radio = 0);
 
-void biharmonic_interp_2(che * mesh, const size_t & old_n_vertices, const size_t & n_vertices, const vector<index_t> & border_vertices, const index_t & k);
+/// Fits the new vertices of a hole with a spline of the rings 0..k of the border, the Wendland
+/// spline is used for more than dense_max centers.
+void biharmonic_interp_2(che * mesh, const size_t & old_n_vertices, const size_t & n_vertices, const vector<index_t> & border_vertices, const index_t & k, const size_t & dense_max = 1000);
 
 #endif //CHE_POISSON_H
 
@@ -0,0 +1,48 @@
+#ifndef DESCRIPTOR_H
+#define DESCRIPTOR_H
+
+#include "che.h"
+#include "include_arma.h"
+
+/*!
+	Spectral descriptors of all the vertices of a mesh, from the K first eigenpairs of the
+	laplacian (eigs_laplacian, cached). HKS and WKS are the product of the squared eigenvectors
+	with a K x T filter matrix, one column by time (HKS) or energy (WKS) sampled in logarithmic
+	scale over the spectrum, then each vertex has a multi-scale signature of T values.
+	GPS has K - 1 values: the eigenvectors divided by the square root of the eigenvalues.
+*/
+class descriptor
+{
+	public:
+		enum signature {	GPS,		///< Global Point Signature.
+							HKS,		///< Heat Kernel Signature.
+							WKS			///< Wave Kernel Signature.
+							};
+
+	private:
+		a_vec eigval;
+		a_mat eigvec;
+		a_mat features;			///< n_vertices x n_features, a row by vertex.
+
+	public:
+		descriptor(const signature & sig, che * mesh, const size_t & K = 100, const size_t & T = 100);
+
+		/// True if the eigenpairs were computed.
+		operator bool() const;
+
+		/// Norm of the signature of the vertex v.
+		real_t operator()(const index_t & v) const;
+
+		const a_mat & matrix() const;
+
+		/// Saves the features as a raw binary n_vertices x n_features (column-major) armadillo matrix.
+		bool save(const string & file) const;
+
+	private:
+		void compute_gps();
+		void compute_hks(const size_t & T);
+		void compute_wks(const size_t & T);
+};
+
+#endif // DESCRIPTOR_H
+
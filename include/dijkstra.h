@@ -4,23 +4,44 @@
 #include "che.h"
 #include "include.h"
 
+#include <cmath>
+
+/*!
+	Shortest paths over the edge graph of the mesh (euclidean length of the edges), from one or
+	multiple sources. The propagation stops at the radio or when the target is reached, then the
+	vertices farther than the stop distance have INFINITY weight and NIL predecessor.
+*/
 class dijkstra
 {
+	public:
+		enum option_t {	HEAP,				///< Dijkstra with a binary heap.
+						DELTA_STEPPING		///< Parallel delta-stepping.
+						};
+
 	private:
 		distance_t * weights;
 		index_t * predecessors;
 		size_t n_vertices;
-		index_t source;
+		vector<index_t> sources;
 
 	public:
 		dijkstra(che * shape, index_t src);
+		dijkstra(	che * shape,
+					const vector<index_t> & srcs,			///< source vertices.
+					const option_t & opt = HEAP,			///< specific the algorithm to execute.
+					const distance_t & radio = INFINITY,	///< execute until the specific radio.
+					const index_t & target = NIL,			///< execute until the target vertex is reached.
+					distance_t delta = 0					///< bucket width of delta-stepping, 0 uses the mean edge.
+					);
 		~dijkstra();
 		distance_t & operator()(index_t i);
 		index_t & operator[](index_t i);
 		void print(ostream & os);
 
 	private:
-		void run(che * shape);
+		void run_heap(che * shape, const distance_t & radio, const index_t & target);
+		void run_delta_stepping(che * shape, const distance_t & radio, const index_t & target, const distance_t & delta);
+		void clear_farther(const distance_t & d);
 };
 
 #endif // DIJKSTRA_H
@@ -19,7 +19,8 @@ class geodesics
 						PTP_CPU,		///< Execute Parallel Toplesets Propagation algorithm on CPU
 						PTP_GPU,		///< Execute Parallel Toplesets Propagation algorithm on GPU
 						HEAT_FLOW,		///< Execute Heat Flow - cholmod (CPU)
-						HEAT_FLOW_GPU	///< Execute Heat Flow - cusparse (GPU)
+						HEAT_FLOW_GPU,	///< Execute Heat Flow - cusparse (GPU)
+						PTP_CPU_ACTIVE	///< Execute Parallel Toplesets Propagation on CPU, only recomputing around changed vertices
 						};
 
 	public:
@@ -37,7 +38,8 @@ class geodesics
 					const option_t & opt = FM,			///< specific the algorithm to execute.
 					const bool & cluster = 0,			///< if clustering vertices to closest source.
 					const size_t & n_iter = 0, 			///< maximum number of iterations.
-					const distance_t & radio = INFINITY	///< execute until the specific radio.
+					const distance_t & radio = INFINITY,	///< execute until the specific radio.
+					const distance_t & tol = 1e-6		///< relative tolerance of PTP_CPU_ACTIVE, 0 to get the PTP_CPU result.
 					);
 
 		virtual ~geodesics();
@@ -50,9 +52,10 @@ class geodesics
 		void normalize();
 
 	private:
-		void execute(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio, const option_t & opt);
+		void execute(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio, const distance_t & tol, const option_t & opt);
 		void run_fastmarching(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio);
 		void run_parallel_toplesets_propagation_cpu(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio);
+		void run_parallel_toplesets_propagation_active_cpu(che * mesh, const vector<index_t> & sources, const distance_t & tol);
 		void run_parallel_toplesets_propagation_gpu(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio);
 		void run_heat_flow(che * mesh, const vector<index_t> & sources);
 		void run_heat_flow_gpu(che * mesh, const vector<index_t> & sources);
@@ -7,6 +7,7 @@
 */
 
 #include "che.h"
+#include "che_corners.h"
 
 index_t iterations(const vector<index_t> &);
 index_t start_v(const index_t & i, const vector<index_t> & limits);
@@ -18,10 +19,36 @@ distance_t * parallel_toplesets_propagation_gpu(che * mesh, const vector<index_t
 
 distance_t * parallel_toplesets_propagation_cpu(che * mesh, const vector<index_t> & sources, const vector<index_t> & limits, const index_t * sorted_index, index_t * clusters = NULL);
 
+/// Work done by parallel_toplesets_propagation_active_cpu.
+struct ptp_stats_t
+{
+	index_t iterations;		///< Executed iterations, iterations(limits) at most.
+	size_t relaxations;		///< Number of update_step calls.
+};
+
+/// PTP recomputing only the vertices of the window next to a vertex changed (relative change > tol)
+/// in the last iteration, it stops when all the toplesets are in the window and nothing changed.
+/// With tol = 0 the distances are the same as parallel_toplesets_propagation_cpu.
+distance_t * parallel_toplesets_propagation_active_cpu(che * mesh, const vector<index_t> & sources, const vector<index_t> & limits, const index_t * sorted_index, const distance_t & tol = 1e-6, index_t * clusters = NULL, ptp_stats_t * stats = NULL);
+
 distance_t farthest_point_sampling_ptp_gpu(che * mesh, vector<index_t> & samples, double & time_fps, size_t n, distance_t radio = 0);
 
+/// Farthest point sampling with one distance field relaxed only where the new sample is closer.
+/// A vertex stops relaxing when its improvement is less than a relative 1e-6, then the distances
+/// match PTP from all the samples up to that tolerance and the samples can differ from the GPU
+/// version when two vertices are almost equally far.
+distance_t farthest_point_sampling_ptp_cpu(che * mesh, vector<index_t> & samples, double & time_fps, size_t n, distance_t radio = 0);
+
+/// Farthest point sampling on GPU if a CUDA device is available, else on CPU.
+distance_t farthest_point_sampling_ptp(che * mesh, vector<index_t> & samples, double & time_fps, size_t n, distance_t radio = 0);
+
+bool cuda_device_available();
+
 distance_t update_step(che * mesh, const distance_t * dist, const index_t & he);
 
+/// Minimum of update_step over the star of v.
+distance_t update_star(const che_corners & table, const distance_t * dist, const index_t & v);
+
 void normalize_ptp(distance_t * dist, const size_t & n);
 
 #endif // GEODESICS_PTP_H
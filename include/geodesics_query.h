@@ -0,0 +1,57 @@
+#ifndef GEODESICS_QUERY_H
+#define GEODESICS_QUERY_H
+
+#include "che.h"
+#include "geodesics.h"
+
+/*!
+	Engine to compute many geodesic queries on the same mesh. Each thread reuses its own scratch
+	(distances, epoch stamps and the list of touched vertices), then a query bounded by a radio
+	costs proportional to the visited region instead of the number of vertices of the mesh.
+	Queries can be called from parallel regions, each query is computed by the calling thread.
+	Supported algorithms: FM and PTP_CPU (local toplesets).
+*/
+class geodesics_query
+{
+	public:
+		/// Scratch of a thread, valid until the next query of the same thread.
+		struct scratch_t
+		{
+			distance_t * dist;			///< Geodesic distances, INFINITY if the vertex was not reached.
+			distance_t * dist_ptp;		///< Second distance buffer used by PTP.
+			index_t * stamp;			///< Epoch stamps: < epoch not visited, epoch front (red), epoch + 1 fixed (black).
+			index_t epoch;
+			vector<index_t> touched;	///< Vertices with a finite distance, reset by the next query.
+			vector<index_t> sorted;		///< Vertices within the radio sorted by their geodesic distances.
+			vector<index_t> limits;		///< PTP: limits of the local toplesets in toplesets.
+			vector<index_t> toplesets;	///< PTP: visited vertices sorted by topological level.
+			link_t link;
+		};
+
+	private:
+		che * mesh;
+		size_t n_vertices;
+		vector<scratch_t> scratch;	///< One scratch per thread, allocated by the first query of the thread.
+
+	public:
+		geodesics_query(che * mesh);
+		virtual ~geodesics_query();
+
+		const scratch_t & query(	const vector<index_t> & sources,						///< source vertices.
+									const distance_t & radio = INFINITY,					///< execute until the specific radio.
+									const geodesics::option_t & opt = geodesics::FM,		///< FM or PTP_CPU.
+									const size_t & n_iter = 0								///< FM: maximum number of fixed vertices.
+									);
+
+		/// Independent queries from each source in parallel, sorted[i] are the vertices within the radio from sources[i].
+		void batch(vector<vector<index_t> > & sorted, const vector<index_t> & sources, const distance_t & radio, const geodesics::option_t & opt = geodesics::FM);
+
+	private:
+		scratch_t & thread_scratch();
+		void reset(scratch_t & s);
+		void run_fastmarching(scratch_t & s, const vector<index_t> & sources, const distance_t & radio, const size_t & n_iter);
+		void run_parallel_toplesets_propagation(scratch_t & s, const vector<index_t> & sources, const distance_t & radio);
+};
+
+#endif // GEODESICS_QUERY_H
+
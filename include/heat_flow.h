@@ -15,6 +15,42 @@
 
 #include <cholmod.h>
 
+/*!
+	Heat method with the factorizations of the two systems, A + dt L (heat flow) and L (poisson),
+	computed once for a mesh. Each set of sources costs two solves with the cached factors, and a
+	batch of sets of sources is solved as one right-hand side with a column per set.
+	The cholmod context is not shared between threads, call the solver from one thread.
+	che::heat_solver caches a solver per mesh, it is dropped when the geometry or the topology change.
+*/
+class heat_flow_solver
+{
+	private:
+		che * mesh;
+		size_t n_vertices;
+		cholmod_common context;
+		cholmod_factor * heat;		///< factorization of A + dt L.
+		cholmod_factor * poisson;	///< factorization of L.
+		cholmod_dense * Y;			///< workspace of cholmod_l_solve2.
+		cholmod_dense * E;			///< workspace of cholmod_l_solve2.
+
+	public:
+		heat_flow_solver(che * mesh);
+		virtual ~heat_flow_solver();
+		heat_flow_solver(const heat_flow_solver &) = delete;				///< owns the cholmod context and factors.
+		heat_flow_solver & operator=(const heat_flow_solver &) = delete;
+
+		/// Returns the geodesic distances from the sources, solve_time is the time of the two solves.
+		distance_t * operator()(const vector<index_t> & sources, double & solve_time);
+
+		/// Returns the n_vertices x sources.size() column-major distances, column i from sources[i].
+		distance_t * batch(const vector<vector<index_t> > & sources, double & solve_time);
+
+	private:
+		cholmod_factor * factorize(cholmod_sparse * M);
+		void solve(cholmod_factor * F, cholmod_dense * b, cholmod_dense * x);
+};
+
+/// Heat method with the solver cached by the mesh (che::heat_solver), only the first call factorizes.
 distance_t * heat_flow(che * mesh, const vector<index_t> & sources, double & solve_time);
 
 distance_t * heat_flow_gpu(che * mesh, const vector<index_t> & sources, double & solve_time);
@@ -25,9 +61,14 @@ void compute_divergence(che * mesh, const a_mat & u, a_mat & div);
 /// base on the code https://github.com/larc/dgpdec-course/tree/master/Geodesics
 double solve_positive_definite(a_mat & x, const a_sp_mat & A, const a_mat & b, cholmod_common * context);
 
-cholmod_dense * arma_2_cholmod(const a_mat & m, cholmod_common * context);
+/// cholmod header sharing the buffers of the armadillo matrix (no copy), valid while S is not modified.
+cholmod_sparse cholmod_view(const a_sp_mat & S);
+
+/// cholmod header sharing the buffer of the armadillo matrix (no copy), valid while D is not resized.
+cholmod_dense cholmod_view(const a_mat & D);
 
-cholmod_sparse * arma_2_cholmod(const a_sp_mat & m, cholmod_common * context);
+/// cholmod header of a column-major n_rows x n_cols buffer (no copy).
+cholmod_dense cholmod_view(real_t * x, const size_t & n_rows, const size_t & n_cols);
 
 /// 
 double solve_positive_definite_gpu(a_mat & x, const a_sp_mat & A, const a_mat & b);
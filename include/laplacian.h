@@ -10,11 +10,45 @@ using namespace Eigen;
 
 typedef SparseMatrix<double> sp_mat_e;
 
+/// Upper bound of the nonzeros of the cotan laplacian: the diagonal and two entries by edge of ET,
+/// exact if no two edges of ET join the same vertices (edges of a non manifold mesh).
+size_t laplacian_nnz(che * mesh);
+
+/*!
+	Assembles the cotan laplacian L = D^T S D straight into CSC arrays from the edges of ET: a count
+	pass gives the column v, the row v and a row by neighbor of v sorted, the weights of the edges
+	of ET joining the same vertices are added. col_ptrs has n_vertices + 1 elements, row_indices and
+	values have laplacian_nnz(mesh) elements, and areas (n_vertices) is the diagonal of the lumped
+	mass matrix A. Returns the number of nonzeros, col_ptrs[n_vertices]. Instantiated for the indices
+	of armadillo (uword), Eigen (int) and cholmod (SuiteSparse_long).
+*/
+template<class I, class T>
+size_t laplacian(che * mesh, I * col_ptrs, I * row_indices, T * values, T * areas);
+
 void laplacian(che * mesh, a_sp_mat & L, a_sp_mat & A);
 
+/// Cotan laplacian restricted to the vertices (local indices in the order of vertices) and their areas,
+/// the diagonal keeps the weights of the edges to the neighbors out of the vertices.
+void laplacian(che * mesh, const vector<index_t> & vertices, a_sp_mat & L, a_vec & areas);
+
 void laplacian(che * mesh, sp_mat_e & L, sp_mat_e & A);
 
-size_t eigs_laplacian(a_vec & eigval, a_mat & eigvec, che * mesh, const a_sp_mat & L, const size_t & K);
+/// Hash of the geometry (GT) and the faces (VT) of the mesh, the key of the spectral cache.
+uint64_t hash_mesh(che * mesh);
+
+enum eigs_option_t {	EIGS_SYM,		///< L x = lambda x with eigs_sym (ARPACK).
+						SHIFT_INVERT,	///< L x = lambda A x, subspace iteration with a cholmod factorization.
+						LOBPCG			///< L x = lambda A x, LOBPCG without factorization.
+						};
+
+/*!
+	Laplacian L, mass matrix A and the K first eigenpairs of L, cached in tmp/<hash_mesh>.spectral.
+	The cache is a binary file with aligned tables (CSC arrays of L, areas, eigenvalues and
+	eigenvectors) read with mmap. Any change of the geometry changes the key, and a cache with
+	more eigenpairs of the same problem serves smaller K. The generalized solvers return
+	A-orthonormal eigenvectors. Returns the number of eigenpairs, 0 if the solver fails.
+*/
+size_t eigs_laplacian(a_vec & eigval, a_mat & eigvec, a_sp_mat & L, a_sp_mat & A, che * mesh, const size_t & K, const eigs_option_t & opt = SHIFT_INVERT);
 
 #endif // LAPLACIAN_H
 
@@ -0,0 +1,65 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "include.h"
+
+#include <vector>
+#include <cstring>
+#include <charconv>
+
+using namespace std;
+
+/*!
+	Read-only memory mapped text/binary file, shared by the mesh readers (che_off, che_ply, che_obj).
+	The file is split at line boundaries in chunks, one per thread, so the lines can be parsed in
+	parallel with the inline functions below.
+	If the file can not be opened or mapped the error is reported and data is NULL with size 0, the
+	same as an empty file, then the readers open an empty mesh.
+*/
+class mapped_file
+{
+	public:
+		const char * data;
+		size_t size;
+
+	public:
+		mapped_file(const string & file);
+		~mapped_file();
+
+		/// Offsets of the lines in [begin, end), empty lines and lines starting with comment are skipped.
+		void split_lines(vector<size_t> & lines, const size_t & begin, const size_t & end, const char & comment = '#') const;
+		void split_lines(vector<size_t> & lines, const size_t & begin = 0, const char & comment = '#') const;
+};
+
+inline const char * skip_spaces(const char * p, const char * end)
+{
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+	return p;
+}
+
+inline const char * skip_token(const char * p, const char * end)
+{
+	while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+	return p;
+}
+
+/// Parse the next number of the line, returns NULL at the end of the line or if it is not a number.
+template<class T>
+inline const char * parse_number(const char * p, const char * end, T & x)
+{
+	p = skip_spaces(p, end);
+	if(p < end && *p == '+') p++;
+
+	from_chars_result r = from_chars(p, end, x);
+	return r.ec == errc() ? r.ptr : NULL;
+}
+
+inline const char * parse_vertex(const char * p, const char * end, real_t * v)
+{
+	for(index_t i = 0; p && i < 3; i++)
+		p = parse_number(p, end, v[i]);
+	return p;
+}
+
+#endif // MAPPED_FILE_H
+
@@ -12,13 +12,62 @@ namespace mdict {
 
 void OMP(a_vec & alpha, a_vec & x, a_mat & D, size_t L);
 
+/// Per-thread memory of batch_OMP, allocated once for a K x m dictionary and sparsity L.
+struct omp_workspace
+{
+	a_mat Phi;				///< K x K gram matrix of the basis of the patch, phi^T phi.
+	a_vec phix;				///< phi^T x.
+	real_t xx;				///< x^T x.
+	a_vec a0;				///< correlations of the atoms with x, D^T x.
+	a_vec c;				///< correlations of the atoms with the residual.
+	a_vec Pa;				///< Phi times the selected atom.
+	a_vec Aa;				///< A alpha.
+	a_vec r;				///< phi^T times the residual of the patch.
+	a_mat G;				///< gram columns D^T d_k of the selected atoms.
+	a_mat Lc;				///< lower Cholesky factor of the gram matrix of the selected atoms.
+	a_vec gamma;			///< coefficients of the selected atoms.
+	a_vec w;
+	arma::uvec selected;	///< selected atoms.
+
+	omp_workspace(const size_t & K, const size_t & m, const size_t & L);
+};
+
+/**
+	Batch-OMP of the patch with the dictionary D = p.phi * A without forming D: the correlations
+	are updated with the gram columns A^T Phi A e_k of the selected atoms, and the least squares
+	coefficients with progressive Cholesky updates of the gram matrix of the selected atoms.
+	Same stopping rule and selection of OMP, without heap allocations in the iterations; it stops
+	early if the selected atom is dependent of the previous ones.
+*/
+void batch_OMP(real_t * alpha, const a_mat & A, const patch & p, const size_t & L, omp_workspace & ws);
+
+/// batch_OMP of the valid patches (patch::valid_xyz), the columns of alpha of the others are not written.
+void OMP_all_patches_batch(a_mat & alpha, const a_mat & A, const vector<patch> & patches, const size_t & M, const size_t & L);
+
 void KSVD(a_mat & D, a_mat & X, size_t L);
 
 void OMP_patch(a_mat & alpha, const a_mat & A, const index_t & i, patch & p, const size_t & L);
 
 void OMP_all_patches_ksvt(a_mat & alpha, a_mat & A, vector<patch> & patches, size_t M, size_t L);
 
-void KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L);
+/**
+	Dictionary learning of the continuous dictionary A. Each iteration codes the patches with
+	batch_OMP in chunks and accumulates, with the same gram matrix phi^T phi of each patch, the
+	normal equations of the atoms in parallel over the atoms, then the result does not depend on
+	the number of threads; then all the atoms are solved in parallel.
+	It stops after max_iter iterations (0 is L) or when the relative decrease of the residual
+	of the patches is less than tol.
+*/
+void KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L, const real_t & tol = 1e-4, size_t max_iter = 0);
+
+/**
+	Online (mini-batch) version of KSVDT: the patches are coded in batches of batch_size in a random
+	order, the normal equations of the atoms are sufficient statistics of the seen patches, scaled
+	by (1 - 1/t)^2 before adding the batch t, and the atoms are solved after each batch.
+	It stops after max_time seconds, max_epochs passes over the patches, or when the relative
+	decrease of the residual of an epoch is less than tol.
+*/
+void online_KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L, const size_t & batch_size, const double & max_time, const real_t & tol = 1e-4, const size_t & max_epochs = 10);
 
 /// DEPRECATED
 void OMP_patch(a_mat & alpha, const a_mat & A, const index_t & i, patch_t & p, const size_t & L);
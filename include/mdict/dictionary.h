@@ -29,7 +29,7 @@ class dictionary
 		distance_t s_radio;						///< sampling geodesic radio.
 		vector<index_t> sampling;				///< samples, center of patches if sampling.
 		vector<patch> patches;				///< vector of patches.
-		vector<vpatches_t> patches_map;		///< invert index vertex to patches.
+		patches_store patches_map;			///< packed patches and invert index vertex to patches.
 
 		double d_time;							///< time of operations.
 		bool d_plot;							///< plot atoms and basis with gnuplot.
@@ -37,6 +37,9 @@ class dictionary
 	public:
 		static size_t L;					///< sparsity, norm L_0, default 10.
 		static size_t T;					///< factor of patches' size, default 5 toplesets.
+		static bool batch_omp;				///< sparse coding with Batch-OMP, default false (OMP).
+		static size_t online_batch;			///< patches per mini-batch of the online learning, 0 (default) learns with KSVDT.
+		static double online_time;			///< time budget in seconds of the online learning, default 60.
 
 	protected:
 		dictionary(	che *const & _mesh, 		///< pointer to input mesh.
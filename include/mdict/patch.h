@@ -15,20 +15,32 @@ namespace mdict {
 class dictionary;
 
 typedef function<bool(const index_t &)> fmask_t;
-typedef vector<pair<index_t, index_t> > vpatches_t;
+typedef pair<index_t, index_t> vpatch_t;		///< (patch, column of the vertex in the xyz of the patch).
+
+/// Range of the pairs vpatch_t of a vertex in the inverse index of patches_store.
+struct vpatches_t
+{
+	const vpatch_t * first;
+	const vpatch_t * last;
+
+	const vpatch_t * begin() const { return first; }
+	const vpatch_t * end() const { return last; }
+	size_t size() const { return last - first; }
+};
 
 /// 
 class patch
 {
 	public:
-		vector<index_t> vertices;		///< Vertices of the patch.
+		vector<index_t> vertices;		///< Vertices of the patch, moved to the patches_store by pack.
 		a_mat T;							///< Transformation matrix.
 		a_vec x;							///< Center point.
-		a_mat xyz;						///< Matrix of points.
-		a_mat phi;
+		a_mat xyz;						///< Matrix of points, aliases the buffer of the patches_store.
+		a_mat phi;						///< Discrete basis, aliases the buffer of the patches_store.
 	
 	public:
 		static size_t expected_nv;		///< Expected number of patch vertices.
+		static size_t min_nvp;			///< Minimum number of vertices of a patch to be coded, default 36.
 
 	public:
 		patch() = default;
@@ -38,21 +50,22 @@ class patch
 					const index_t & v,				///< center vertex of the patch.
 					const size_t & n_toplevels,		///< number of toplevels to jet fitting.
 					const distance_t & radio,		///< euclidean radio in XY of the patch.
-					index_t * _toplevel = NULL		///< aux memory to gather toplevel vertices.
+					index_t * _toplevel = NULL		///< aux memory to gather toplevel vertices, n_vertices entries set to NIL, it is left set to NIL.
 					);
 
 		void transform();
 		
 		void itransform();
-		
-		void reset_xyz(	che * mesh,
-						vector<vpatches_t> & vpatches,
-						const index_t & p,
-						const fmask_t & mask = nullptr
-						);
+
+		/// The patch has more than min_nvp vertices, as patch_t::valid_xyz.
+		bool valid_xyz() const;
+
+		/// xyz and phi alias the buffers (no copy), the patches_store keeps the memory.
+		void bind(real_t * xyz_mem, real_t * phi_mem, const size_t & n, const size_t & dim);
 
 	private:
 		/// Gather the vertices needed to compute the jet_fit_directions of the patch.
+		/// toplevel is NIL on entry and only the touched entries are reset on exit.
 		void gather_vertices(	che * mesh,
 								const index_t & v,
 								const size_t & n_toplevels,
@@ -60,6 +73,7 @@ class patch
 								);
 		
 		/// Gather the vertices filter by radio in the local coordinates require initialize T and x.
+		/// toplevel is NIL on entry and only the touched entries are reset on exit.
 		void gather_vertices(	che * mesh,
 								const index_t & v,
 								const distance_t & radio,
@@ -75,6 +89,47 @@ class patch
 	friend class dictionary;
 };
 
+/**
+	Packed storage of the patches of a dictionary: the vertices of all the patches in one CSR
+	array, the coordinates and the phi of all the patches in two contiguous buffers (the xyz and
+	phi of each patch alias them), and the CSR inverse index from the vertices to the patches.
+*/
+class patches_store
+{
+	private:
+		size_t M = 0;
+		size_t n_vertices = 0;
+		index_t * offsets = NULL;			///< vertices of the patch s: vertices[offsets[s], offsets[s + 1]).
+		index_t * vertices = NULL;
+		index_t * xyz_offsets = NULL;		///< columns of the patch s in xyz: [xyz_offsets[s], xyz_offsets[s + 1]).
+		real_t * xyz = NULL;				///< 3 x xyz_offsets[M] coordinates.
+		real_t * phi = NULL;				///< phi of the patch s at phi + dim * xyz_offsets[s].
+		index_t * map_offsets = NULL;		///< pairs of the vertex v: map[map_offsets[v], map_offsets[v + 1]).
+		vpatch_t * map = NULL;
+
+	public:
+		patches_store() = default;
+		patches_store(const patches_store &) = delete;				///< owns the buffers.
+		patches_store & operator=(const patches_store &) = delete;
+		~patches_store();
+
+		/// Moves the vertices of the patches to the CSR array, the vectors of the patches are released.
+		void pack(vector<patch> & patches, const size_t & n_vertices);
+
+		/// Copies the coordinates of the vertices in the mask, binds the xyz and the n x dim phi of the
+		/// patches to the buffers, and builds the inverse index with a parallel counting pass.
+		void reset_xyz(che * mesh, vector<patch> & patches, const size_t & dim, const fmask_t & mask = nullptr);
+
+		/// Number of vertices of the patch s.
+		size_t size(const index_t & s) const;
+
+		/// Pairs (patch, column) of the vertex v.
+		vpatches_t operator[](const index_t & v) const;
+
+	private:
+		void free_xyz();
+};
+
 } // mdict
 
 #endif // PATCH_H
@@ -0,0 +1,26 @@
+#ifndef TEST_REGRESSION_H
+#define TEST_REGRESSION_H
+
+#include "che.h"
+
+/// Execute the regression tests of the cpu algorithms on each mesh, returns the number of failed tests.
+int main_test_regression(const int & nargs, const char ** args);
+
+/// PTP active with tol = 0 must return the same distances as PTP cpu.
+bool test_ptp_active(che * mesh);
+
+/// The CSC cotan laplacian must be D^T S D, symmetric and with sorted columns.
+bool test_laplacian(che * mesh);
+
+/// test_laplacian on a mesh with an edge of three triangles and a vertex joining two fans.
+bool test_laplacian_non_manifold();
+
+/// batch_OMP must return the codes of OMP (OMP_patch) on random patches and dictionaries.
+bool test_batch_omp();
+
+/// KSVDT must reduce the residual of patches of a perturbed dictionary, with the same result for any
+/// number of threads.
+bool test_ksvdt();
+
+#endif // TEST_REGRESSION_H
+
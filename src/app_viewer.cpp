@@ -1,5 +1,7 @@
 #include "app_viewer.h"
 
+#include <cstring>
+
 using namespace mdict;
 
 // elapsed time in seconds
@@ -12,7 +14,7 @@ int viewer_main(int nargs, const char ** args)
 	TIC(load_time)
 	vector<che *> meshes;
 	for(int i = 1; i < nargs; i++)
-		meshes.push_back(new che_off(args[i]));
+		meshes.push_back(load_mesh(args[i]));
 	TOC(load_time)
 	debug(load_time)
 
@@ -108,7 +110,7 @@ void viewer_process_poisson(const index_t & k)
 	size_t old_n_vertices = viewer::mesh()->n_vertices();
 	delete [] fill_all_holes(viewer::mesh());
 
-	TIC(load_time) poisson(viewer::mesh(), old_n_vertices, k); TOC(load_time)
+	TIC(load_time) poisson_local(viewer::mesh(), old_n_vertices, k); TOC(load_time)
 	debug(load_time)
 
 //	paint_holes_vertices();
@@ -157,6 +159,7 @@ void viewer_process_noise()
 		viewer::mesh()->get_vertex(v) += (!p) * r * viewer::mesh()->normal(v);
 	}
 
+	viewer::mesh()->update_geometry();
 	viewer::mesh().update_normals();
 }
 
@@ -175,6 +178,7 @@ void viewer_process_black_noise()
 		if(!p) viewer::vcolor(v) = INFINITY;
 	}
 
+	viewer::mesh()->update_geometry();
 	viewer::mesh().update_normals();
 }
 
@@ -191,21 +195,17 @@ void viewer_process_functional_maps()
 	size_t K = 50;
 
 	a_sp_mat L, A;
-
-	TIC(load_time) laplacian(viewer::mesh(), L, A); TOC(load_time)
-	debug(load_time)
-
 	a_vec eigval;
 	a_mat eigvec;
 
-	TIC(load_time) K = eigs_laplacian(eigval, eigvec, viewer::mesh(), L, K); TOC(load_time)
+	TIC(load_time) K = eigs_laplacian(eigval, eigvec, L, A, viewer::mesh(), K); TOC(load_time)
 	debug(load_time)
 	
 	debug(K)
 	K = K < N_MESHES ? K : N_MESHES;
 	for(index_t k = 0; k < N_MESHES; k++)
 	{
-		if(k) viewer::add_mesh({new che_off(viewer::mesh()->filename())});
+		if(k) viewer::add_mesh({load_mesh(viewer::mesh()->filename())});
 		viewer::current = k;
 
 		eigvec.col(k) -= eigvec.col(k).min();
@@ -219,33 +219,20 @@ void viewer_process_functional_maps()
 	viewer::current = 0;
 }
 
-void viewer_process_wks()
+void viewer_process_descriptor(const descriptor::signature & sig)
 {
-	debug_me(APP_VIEWER)
-
 	size_t K = 50, T = 100;
 
-	a_sp_mat L, A;
-
-	TIC(load_time) laplacian(viewer::mesh(), L, A); TOC(load_time)
+	TIC(load_time) descriptor features(sig, viewer::mesh(), K, T); TOC(load_time)
 	debug(load_time)
 
-	a_vec eigval;
-	a_mat eigvec;
-
-	TIC(load_time) K = eigs_laplacian(eigval, eigvec, viewer::mesh(), L, K); TOC(load_time)
-	debug(load_time)
+	if(!features) return;
 
 	distance_t max_s = 0;
 	#pragma omp parallel for reduction(max: max_s)
 	for(index_t v = 0; v < viewer::mesh()->n_vertices(); v++)
 	{
-		a_vec s(T, arma::fill::zeros);
-		for(index_t t = 0; t < T; t++)
-		for(index_t k = 1; k < K; k++)
-			s(t) += exp(-eigval(k) * t) * eigvec(v, k) * eigvec(v, k);
-
-		viewer::vcolor(v) = norm(s);
+		viewer::vcolor(v) = features(v);
 		max_s = max(max_s, viewer::vcolor(v));
 	}
 
@@ -254,80 +241,25 @@ void viewer_process_wks()
 		viewer::vcolor(v) /= max_s;
 }
 
-void viewer_process_hks()
+void viewer_process_wks()
 {
 	debug_me(APP_VIEWER)
 
-	size_t K = 50;
-	size_t T = 100;
-
-	a_sp_mat L, A;
-
-	TIC(load_time) laplacian(viewer::mesh(), L, A); TOC(load_time)
-	debug(load_time)
-
-	a_vec eigval;
-	a_mat eigvec;
-
-	TIC(load_time) K = eigs_laplacian(eigval, eigvec, viewer::mesh(), L, K); TOC(load_time)
-	debug(load_time)
-
-	if(!K) return;
-
-	distance_t max_s = 0;
-	#pragma omp parallel for reduction(max: max_s)
-	for(index_t v = 0; v < viewer::mesh()->n_vertices(); v++)
-	{
-		a_vec s(T, arma::fill::zeros);
-		for(index_t t = 0; t < T; t++)
-		for(index_t k = 1; k < K; k++)
-			s(t) += exp(-abs(eigval(k)) * t) * eigvec(v, k) * eigvec(v, k);
+	viewer_process_descriptor(descriptor::WKS);
+}
 
-		viewer::vcolor(v) = norm(abs(arma::fft(s,128)));
-		//viewer::vcolor(v) = norm(s);
-		max_s = max(max_s, viewer::vcolor(v));
-	}
+void viewer_process_hks()
+{
+	debug_me(APP_VIEWER)
 
-	#pragma omp parallel for
-	for(index_t v = 0; v < viewer::mesh()->n_vertices(); v++)
-		viewer::vcolor(v) /= max_s;
+	viewer_process_descriptor(descriptor::HKS);
 }
 
 void viewer_process_gps()
 {
 	debug_me(APP_VIEWER)
 
-	size_t K = 50;
-
-	a_sp_mat L, A;
-
-	TIC(load_time) laplacian(viewer::mesh(), L, A); TOC(load_time)
-	debug(load_time)
-
-	a_vec eigval;
-	a_mat eigvec;
-
-	TIC(load_time) K = eigs_laplacian(eigval, eigvec, viewer::mesh(), L, K); TOC(load_time)
-	debug(load_time)
-	eigvec = abs(eigvec);
-	eigvec.col(0).zeros();
-	for(index_t i = 1; i < K; i++)
-		eigvec.col(i) /= sqrt(abs(eigval(i)));
-
-	a_mat data = eigvec.t();
-	a_mat means;
-
-	distance_t max_s = 0;
-	#pragma omp parallel for reduction(max: max_s)
-	for(index_t v = 0; v < viewer::mesh()->n_vertices(); v++)
-	{
-		viewer::vcolor(v) = norm(eigvec.row(v));
-			max_s = max(max_s, viewer::vcolor(v));
-	}
-
-	#pragma omp parallel for
-	for(index_t v = 0; v < viewer::mesh()->n_vertices(); v++)
-		viewer::vcolor(v) /= max_s;
+	viewer_process_descriptor(descriptor::GPS);
 }
 
 void viewer_process_key_points()
@@ -364,6 +296,7 @@ void viewer_process_mdict_patch()
 	TIC(load_time)
 	che * mesh = viewer::mesh();
 	index_t * toplevel = new index_t[mesh->n_vertices()];
+	memset(toplevel, -1, sizeof(index_t) * mesh->n_vertices());
 	size_t avg_nvp = 0;
 
 	vertex vdir;
@@ -538,7 +471,7 @@ void viewer_process_farthest_point_sampling_radio()
 	double time_fps;
 
 	TIC(load_time)
-	radio = farthest_point_sampling_ptp_gpu(viewer::mesh(), viewer::select_vertices, time_fps, NIL, radio);
+	radio = farthest_point_sampling_ptp(viewer::mesh(), viewer::select_vertices, time_fps, NIL, radio);
 	TOC(load_time)
 	debug(time_fps)
 
@@ -759,7 +692,7 @@ void viewer_process_edge_collapse()
 	debug(load_time)
 
 	if(viewer::n_meshes < 2)
-		viewer::add_mesh({new che_off(viewer::mesh()->filename())});
+		viewer::add_mesh({load_mesh(viewer::mesh()->filename())});
 
 	viewer::corr_mesh[1].init(viewer::meshes[1]->n_vertices(), viewer::current, sampling);
 	viewer::current = 1;
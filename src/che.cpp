@@ -1,9 +1,13 @@
 #include "che.h"
+#include "che_corners.h"
+#include "heat_flow.h"
 
 #include <cstring>
 #include <cmath>
 #include <cassert>
 #include <set>
+#include <cstdint>
+#include <algorithm>
 
 #include "viewer/viewer.h"
 
@@ -83,6 +87,8 @@ bool che::is_border_e(const index_t & e) const
 
 void che::flip(const index_t & e)
 {
+	delete_caches();
+
 	index_t ha = ET[e];
 	index_t hb = OT[ha];
 
@@ -313,6 +319,8 @@ size_t che::genus() const
 
 void che::normalize()
 {
+	delete_caches();
+
 	vertex center;
 
 	#pragma omp parallel for
@@ -460,11 +468,18 @@ vertex & che::get_vertex(index_t v)
 	return GT[v];
 }
 
+void che::update_geometry()
+{
+	delete_caches();
+}
+
 void che::set_vertices(const vertex *const& positions, size_t n, const index_t & v_i)
 {
 	if(!positions) return;
 	if(!n) n = n_vertices_;
 	memcpy(GT + v_i, positions, sizeof(vertex) * n);
+
+	delete_caches();
 }
 
 const string & che::filename() const
@@ -749,6 +764,54 @@ void che::remove_vertices(const vector<index_t> & vertices)
 	debug_me(removing vertex);
 }
 
+/// Merges all the meshes with one rebuild of the tables, meshes[i] can be NULL. The first
+/// com_vertices[i].size() vertices of meshes[i] are the vertices com_vertices[i] of this mesh,
+/// the rest of its vertices are appended in the order of the meshes.
+void che::merge(che * const * meshes, const vector<index_t> * com_vertices, const size_t & n_meshes)
+{
+	vector<size_t> v_offset(n_meshes + 1), f_offset(n_meshes + 1);
+	v_offset[0] = n_vertices_;
+	f_offset[0] = n_faces_;
+
+	for(index_t i = 0; i < n_meshes; i++)
+	{
+		const che * mesh = meshes[i];
+		v_offset[i + 1] = v_offset[i] + (mesh ? mesh->n_vertices_ - com_vertices[i].size() : 0);
+		f_offset[i + 1] = f_offset[i] + (mesh ? mesh->n_faces_ : 0);
+	}
+
+	size_t nv = v_offset[n_meshes];
+	size_t nf = f_offset[n_meshes];
+
+	vertex * aGT = new vertex[nv];
+	index_t * aVT = new index_t[P * nf];
+
+	memcpy(aGT, GT, sizeof(vertex) * n_vertices_);
+	memcpy(aVT, VT, sizeof(index_t) * n_half_edges_);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(index_t i = 0; i < n_meshes; i++)
+	{
+		const che * mesh = meshes[i];
+		if(!mesh) continue;
+
+		const vector<index_t> & com = com_vertices[i];
+		const size_t ncv = com.size();
+
+		memcpy(aGT + v_offset[i], mesh->GT + ncv, sizeof(vertex) * (mesh->n_vertices_ - ncv));
+
+		index_t * t_aVT = aVT + P * f_offset[i];
+		for(index_t he = 0; he < mesh->n_half_edges_; he++)
+			t_aVT[he] = mesh->VT[he] < ncv ? com[mesh->VT[he]] : mesh->VT[he] - ncv + v_offset[i];
+	}
+
+	delete_me();
+	init(aGT, nv, aVT, nf);
+
+	delete [] aGT;
+	delete [] aVT;
+}
+
 void che::merge(const che * mesh, const vector<index_t> & com_vertices)
 {
 //	write_file("big.off");
@@ -860,6 +923,8 @@ debug_me(fill holes)
 
 void che::set_head_vertices(index_t * head, const size_t & n)
 {
+	delete_caches();
+
 	for(index_t v, i = 0; i < n; i++)
 	{
 		v = head[i];
@@ -887,6 +952,215 @@ void che::set_head_vertices(index_t * head, const size_t & n)
 	}
 }
 
+/// Interleave the bits of the quantized coordinates, most significant bits first.
+static uint64_t interleave_bits(const uint32_t * X, const index_t & bits)
+{
+	uint64_t key = 0;
+	for(index_t b = bits; b--; )
+		for(index_t i = 0; i < 3; i++)
+			key = (key << 1) | ((X[i] >> b) & 1);
+	return key;
+}
+
+/// Hilbert index of the quantized coordinates (J. Skilling, Programming the Hilbert curve, 2004).
+static uint64_t hilbert_key(uint32_t * X, const index_t & bits)
+{
+	uint32_t M = 1u << (bits - 1), P, Q, t;
+
+	for(Q = M; Q > 1; Q >>= 1)
+	{
+		P = Q - 1;
+		for(index_t i = 0; i < 3; i++)
+			if(X[i] & Q) X[0] ^= P;
+			else
+			{
+				t = (X[0] ^ X[i]) & P;
+				X[0] ^= t;
+				X[i] ^= t;
+			}
+	}
+
+	for(index_t i = 1; i < 3; i++)
+		X[i] ^= X[i - 1];
+
+	t = 0;
+	for(Q = M; Q > 1; Q >>= 1)
+		if(X[2] & Q) t ^= Q - 1;
+
+	for(index_t i = 0; i < 3; i++)
+		X[i] ^= t;
+
+	return interleave_bits(X, bits);
+}
+
+// Reorder the vertices by the order option and the faces by their smallest new vertex index,
+// all tables are permuted in place (the topology is not rebuilt). Returns the permutation
+// new index -> old index of the vertices, it must be deleted by the caller.
+index_t * che::reorder(const order_t & order)
+{
+	delete_caches();
+
+	index_t * perm = new index_t[n_vertices_];		// new -> old
+	index_t * inv = new index_t[n_vertices_];		// old -> new
+
+	if(order == TOPLESETS)
+	{
+		memset(inv, 255, sizeof(index_t) * n_vertices_);
+
+		index_t n = 0;
+		link_t v_link;
+		for(index_t s = 0; s < n_vertices_; s++)
+		{
+			if(inv[s] != NIL) continue;
+
+			inv[s] = n;
+			perm[n++] = s;
+
+			for(index_t i = inv[s]; i < n; i++)
+			{
+				v_link.clear();
+				link(v_link, perm[i]);
+				for(index_t he: v_link)
+					if(inv[VT[he]] == NIL)
+					{
+						inv[VT[he]] = n;
+						perm[n++] = VT[he];
+					}
+			}
+		}
+	}
+	else
+	{
+		const index_t bits = 21;
+
+		vertex pmin = GT[0], pmax = GT[0];
+		for(index_t v = 1; v < n_vertices_; v++)
+		for(index_t i = 0; i < 3; i++)
+		{
+			pmin[i] = min(pmin[i], GT[v][i]);
+			pmax[i] = max(pmax[i], GT[v][i]);
+		}
+
+		real_t scale = max(max(pmax.x - pmin.x, pmax.y - pmin.y), pmax.z - pmin.z);
+		scale = scale > 0 ? ((1u << bits) - 1) / scale : 0;
+
+		vector<pair<uint64_t, index_t> > keys(n_vertices_);
+
+		#pragma omp parallel for
+		for(index_t v = 0; v < n_vertices_; v++)
+		{
+			uint32_t X[3];
+			for(index_t i = 0; i < 3; i++)
+				X[i] = (GT[v][i] - pmin[i]) * scale;
+
+			keys[v].first = order == MORTON ? interleave_bits(X, bits) : hilbert_key(X, bits);
+			keys[v].second = v;
+		}
+
+		sort(keys.begin(), keys.end());
+
+		#pragma omp parallel for
+		for(index_t i = 0; i < n_vertices_; i++)
+		{
+			perm[i] = keys[i].second;
+			inv[perm[i]] = i;
+		}
+	}
+
+	// faces sorted by the smallest new index of their vertices (counting sort, stable)
+	index_t * fperm = new index_t[n_faces_];		// new -> old
+	index_t * finv = new index_t[n_faces_];		// old -> new
+	index_t * count = new index_t[n_vertices_ + 1];
+	memset(count, 0, sizeof(index_t) * (n_vertices_ + 1));
+
+	#pragma omp parallel for
+	for(index_t f = 0; f < n_faces_; f++)
+	{
+		index_t v = min(min(inv[VT[P * f]], inv[VT[P * f + 1]]), inv[VT[P * f + 2]]);
+		finv[f] = v;
+
+		#pragma omp atomic
+		count[v + 1]++;
+	}
+
+	for(index_t v = 0; v < n_vertices_; v++)
+		count[v + 1] += count[v];
+
+	for(index_t f = 0; f < n_faces_; f++)
+	{
+		finv[f] = count[finv[f]]++;
+		fperm[finv[f]] = f;
+	}
+
+	delete [] count;
+
+	// old he -> new he
+	auto he_map = [&](const index_t & he) -> index_t
+	{
+		return he == NIL ? NIL : P * finv[trig(he)] + he % P;
+	};
+
+	// edges sorted by their new half-edge
+	index_t * einv = new index_t[n_edges_];			// old -> new
+	index_t * he_edge = new index_t[n_half_edges_];
+	memset(he_edge, 255, sizeof(index_t) * n_half_edges_);
+
+	#pragma omp parallel for
+	for(index_t e = 0; e < n_edges_; e++)
+		he_edge[he_map(ET[e])] = e;
+
+	for(index_t he = 0, e = 0; he < n_half_edges_; he++)
+		if(he_edge[he] != NIL) einv[he_edge[he]] = e++;
+
+	delete [] he_edge;
+
+	// permute the tables, copying back into the same arrays (they could be mapped, see che_bin)
+	vertex * tGT = new vertex[n_vertices_];
+	index_t * tmp = new index_t[max(n_vertices_, n_half_edges_)];
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+		tGT[v] = GT[perm[v]];
+	memcpy(GT, tGT, sizeof(vertex) * n_vertices_);
+	delete [] tGT;
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+		tmp[v] = he_map(EVT[perm[v]]);
+	memcpy(EVT, tmp, sizeof(index_t) * n_vertices_);
+
+	#pragma omp parallel for
+	for(index_t he = 0; he < n_half_edges_; he++)
+		tmp[he] = inv[VT[P * fperm[trig(he)] + he % P]];
+	memcpy(VT, tmp, sizeof(index_t) * n_half_edges_);
+
+	#pragma omp parallel for
+	for(index_t he = 0; he < n_half_edges_; he++)
+		tmp[he] = he_map(OT[P * fperm[trig(he)] + he % P]);
+	memcpy(OT, tmp, sizeof(index_t) * n_half_edges_);
+
+	#pragma omp parallel for
+	for(index_t he = 0; he < n_half_edges_; he++)
+		tmp[he] = einv[EHT[P * fperm[trig(he)] + he % P]];
+	memcpy(EHT, tmp, sizeof(index_t) * n_half_edges_);
+
+	#pragma omp parallel for
+	for(index_t e = 0; e < n_edges_; e++)
+		tmp[einv[e]] = he_map(ET[e]);
+	memcpy(ET, tmp, sizeof(index_t) * n_edges_);
+
+	for(index_t b = 0; b < n_borders_; b++)
+		BT[b] = inv[BT[b]];
+
+	delete [] tmp;
+	delete [] einv;
+	delete [] fperm;
+	delete [] finv;
+	delete [] inv;
+
+	return perm;
+}
+
 index_t che::link_intersect(const index_t & v_a, const index_t & v_b)
 {
 	index_t intersect = 0;
@@ -1142,6 +1416,32 @@ corr_t che::find_corr(const vertex & v, const vertex & n, const vector<index_t>
 	return corr_d;
 }
 
+const che_corners & che::corners()
+{
+	che_corners * c;
+
+	#pragma omp critical(che_corners)
+	{
+		if(!corners_) corners_ = new che_corners(this);
+		c = corners_;
+	}
+
+	return *c;
+}
+
+heat_flow_solver & che::heat_solver()
+{
+	heat_flow_solver * h;
+
+	#pragma omp critical(che_heat_solver)
+	{
+		if(!heat_solver_) heat_solver_ = new heat_flow_solver(this);
+		h = heat_solver_;
+	}
+
+	return *h;
+}
+
 void che::init(const vertex * vertices, const index_t & n_v, const index_t * faces, const index_t & n_f)
 {
 	init(n_v, n_f);
@@ -1156,13 +1456,23 @@ void che::init(const vertex * vertices, const index_t & n_v, const index_t * fac
 
 void che::init(const string & file)
 {
+	init(0, 0);					// empty mesh if the file can not be read
 	filename_ = file;
 	read_file(filename_);
+
+	// binary formats (che_bin) already store the topology tables
+	if(!n_vertices_ || loads_topology()) return;
+
 	update_evt_ot_et();
 	update_eht();
 	update_bt();
 }
 
+bool che::loads_topology() const
+{
+	return false;
+}
+
 void che::init(const size_t & n_v, const size_t & n_f)
 {
 	n_vertices_ = n_v;
@@ -1170,7 +1480,7 @@ void che::init(const size_t & n_v, const size_t & n_f)
 	n_half_edges_ = n_edges_ = n_borders_ = 0;
 
 	GT = NULL;
-	VT = OT = EVT = ET = BT = NULL;
+	VT = OT = EVT = ET = EHT = BT = NULL;
 	manifold = true;
 
 	if(!n_vertices_ || !n_faces_)
@@ -1191,28 +1501,80 @@ void che::init(const size_t & n_v, const size_t & n_f)
 
 void che::update_evt_ot_et()
 {
-	vector<index_t> * he_p_vertex = new vector<index_t>[n_vertices_];
+	// CSR table of half-edges per vertex: he_p_vertex[he_begin[v] .. he_begin[v + 1]) starts at v
+	index_t * he_begin = new index_t[n_vertices_ + 1];
+	index_t * he_p_vertex = new index_t[n_half_edges_];
 
-	memset(EVT, 255, sizeof(index_t) * n_vertices_);
+	memset(he_begin, 0, sizeof(index_t) * (n_vertices_ + 1));
 
-	//vertex table
+	#pragma omp parallel for
 	for(index_t he = 0; he < n_half_edges_; he++)
 	{
-		EVT[VT[he]] = he;
-		he_p_vertex[VT[he]].push_back(he);
+		#pragma omp atomic
+		he_begin[VT[he] + 1]++;
 	}
 
+	for(index_t v = 0; v < n_vertices_; v++)
+		he_begin[v + 1] += he_begin[v];
+
+	// counting sort, each list keeps the half-edges in increasing order
+	for(index_t he = 0; he < n_half_edges_; he++)
+		he_p_vertex[he_begin[VT[he]]++] = he;
+
+	memmove(he_begin + 1, he_begin, sizeof(index_t) * n_vertices_);
+	he_begin[0] = 0;
+
+	//vertex table
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+		EVT[v] = he_begin[v] < he_begin[v + 1] ? he_p_vertex[he_begin[v + 1] - 1] : NIL;
+
 	//opposite table - edge table
 	memset(OT, 255, sizeof(index_t) * n_half_edges_);
 
+	// opposite candidate of each half-edge, more than one only in non manifold edges
+	index_t * ot = new index_t[n_half_edges_];
+	bool multiple = false;
+
+	#pragma omp parallel for reduction(||: multiple)
+	for(index_t he = 0; he < n_half_edges_; he++)
+	{
+		index_t n = 0;
+		ot[he] = NIL;
+
+		for(index_t i = he_begin[VT[he]]; i < he_begin[VT[he] + 1]; i++)
+		{
+			const index_t & h = he_p_vertex[i];
+			if(VT[prev(h)] == VT[next(he)])
+			{
+				ot[he] = prev(h);
+				n++;
+			}
+		}
+
+		multiple = multiple || n > 1;
+	}
+
 	vector<index_t> et;
+	et.reserve((n_half_edges_ >> 1) + n_vertices_);
+
 	for(index_t he = 0; he < n_half_edges_; he++)
 	{
 		if(OT[he] == NIL)
 		{
 			et.push_back(he);
-			for(index_t h: he_p_vertex[VT[he]])
+
+			if(!multiple)
 			{
+				if(ot[he] != NIL)
+				{
+					OT[he] = ot[he];
+					OT[ot[he]] = he;
+				}
+			}
+			else for(index_t i = he_begin[VT[he]]; i < he_begin[VT[he] + 1]; i++)
+			{
+				const index_t & h = he_p_vertex[i];
 				if(VT[prev(h)] == VT[next(he)])
 				{
 					OT[he] = prev(h);
@@ -1239,13 +1601,8 @@ void che::update_evt_ot_et()
 			else EVT[VT[he]] = he;
 		}
 
-	for(index_t v = 0; v < n_vertices_; v++)
-		if(EVT[v] >= n_half_edges_)
-		{
-//			debug(EVT[v])
-//			assert(EVT[v] < n_half_edges_);
-		}
-
+	delete [] ot;
+	delete [] he_begin;
 	delete [] he_p_vertex;
 }
 
@@ -1290,6 +1647,8 @@ void che::update_bt()
 
 void che::delete_me()
 {
+	delete_caches();
+
 	if(GT) delete [] GT;
 	if(VT) delete [] VT;
 	if(OT) delete [] OT;
@@ -1299,3 +1658,18 @@ void che::delete_me()
 	if(BT) delete [] BT;
 }
 
+void che::delete_caches()
+{
+	#pragma omp critical(che_corners)
+	{
+		delete corners_;
+		corners_ = NULL;
+	}
+
+	#pragma omp critical(che_heat_solver)
+	{
+		delete heat_solver_;
+		heat_solver_ = NULL;
+	}
+}
+
@@ -0,0 +1,209 @@
+#include "che_bin.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+che_bin::che_bin(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f)
+{
+	mapped = NULL;
+	init(vertices, n_v, faces, n_f);
+}
+
+che_bin::che_bin(const size_t & n_v, const size_t & n_f)
+{
+	mapped = NULL;
+	init(n_v, n_f);
+}
+
+che_bin::che_bin(const string & file)
+{
+	mapped = NULL;
+	init(file);
+}
+
+che_bin::~che_bin()
+{
+	unmap();
+}
+
+bool che_bin::loads_topology() const
+{
+	return true;
+}
+
+void che_bin::read_file(const string & file)
+{
+	mapped = NULL;
+	mapped_size = 0;
+
+	n_vertices_ = n_faces_ = n_half_edges_ = n_edges_ = n_borders_ = 0;
+	manifold = true;
+
+	GT = NULL;
+	VT = OT = EVT = ET = EHT = BT = NULL;
+
+	// on any error the mesh is left empty (n_vertices() == 0)
+	auto error = [&](const char * message)
+	{
+		cerr << "Error: " << file << ": " << message << endl;
+		unmap();
+	};
+
+	int fd = open(file.c_str(), O_RDONLY);
+	if(fd == -1) return error(strerror(errno));
+
+	struct stat st;
+	if(fstat(fd, &st) == -1)
+	{
+		close(fd);
+		return error(strerror(errno));
+	}
+
+	if((size_t) st.st_size < sizeof(header_t))
+	{
+		close(fd);
+		return error("too small for a CHE header");
+	}
+
+	void * data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED) return error(strerror(errno));
+
+	mapped = (char *) data;
+	mapped_size = st.st_size;
+
+	const header_t & h = *((header_t *) mapped);
+
+	if(strncmp(h.magic, "CHEB", 4)) return error("not a CHE file");
+	if(h.version != VERSION) return error("unsupported version");
+	if(h.real_size != sizeof(real_t) || h.index_size != sizeof(index_t)) return error("different real_t or index_t size");
+
+	// the sizes, the tables in order, after the header and inside the file
+	if(h.n_vertices > mapped_size || h.n_half_edges > mapped_size || h.n_edges > mapped_size || h.n_borders > mapped_size)
+		return error("corrupted header");
+	if(h.n_half_edges != che::P * h.n_faces || h.n_edges > h.n_half_edges || h.n_borders > h.n_half_edges)
+		return error("corrupted header");
+
+	const size_t sizes[7] = {	sizeof(vertex) * h.n_vertices,
+								sizeof(index_t) * h.n_half_edges,
+								sizeof(index_t) * h.n_half_edges,
+								sizeof(index_t) * h.n_vertices,
+								sizeof(index_t) * h.n_edges,
+								sizeof(index_t) * h.n_half_edges,
+								sizeof(index_t) * h.n_borders };
+
+	size_t end = sizeof(header_t);
+	for(index_t i = 0; i < 7; i++)
+	{
+		if(h.offset[i] < end || h.offset[i] > mapped_size || sizes[i] > mapped_size - h.offset[i])
+			return error("truncated or corrupted tables");
+		end = h.offset[i] + sizes[i];
+	}
+
+	n_vertices_ = h.n_vertices;
+	n_faces_ = h.n_faces;
+	n_half_edges_ = h.n_half_edges;
+	n_edges_ = h.n_edges;
+	n_borders_ = h.n_borders;
+	manifold = h.manifold;
+
+	GT = (vertex *) (mapped + h.offset[0]);
+	VT = (index_t *) (mapped + h.offset[1]);
+	OT = (index_t *) (mapped + h.offset[2]);
+	EVT = (index_t *) (mapped + h.offset[3]);
+	ET = (index_t *) (mapped + h.offset[4]);
+	EHT = (index_t *) (mapped + h.offset[5]);
+	BT = n_borders_ ? (index_t *) (mapped + h.offset[6]) : NULL;
+}
+
+void che_bin::write_file(const string & file) const
+{
+	write_file(this, file);
+}
+
+bool che_bin::write_file(const che * mesh, const string & file)
+{
+	header_t h;
+	memset(&h, 0, sizeof(header_t));
+
+	memcpy(h.magic, "CHEB", 4);
+	h.version = VERSION;
+	h.real_size = sizeof(real_t);
+	h.index_size = sizeof(index_t);
+	h.manifold = mesh->manifold;
+	h.n_vertices = mesh->n_vertices_;
+	h.n_faces = mesh->n_faces_;
+	h.n_half_edges = mesh->n_half_edges_;
+	h.n_edges = mesh->n_edges_;
+	h.n_borders = mesh->n_borders_;
+
+	const char * tables[7] = {	(char *) mesh->GT, (char *) mesh->VT, (char *) mesh->OT, (char *) mesh->EVT,
+								(char *) mesh->ET, (char *) mesh->EHT, (char *) mesh->BT };
+	const size_t sizes[7] = {	sizeof(vertex) * mesh->n_vertices_,
+								sizeof(index_t) * mesh->n_half_edges_,
+								sizeof(index_t) * mesh->n_half_edges_,
+								sizeof(index_t) * mesh->n_vertices_,
+								sizeof(index_t) * mesh->n_edges_,
+								sizeof(index_t) * mesh->n_half_edges_,
+								sizeof(index_t) * mesh->n_borders_ };
+
+	auto aligned = [](const size_t & offset) -> size_t
+	{
+		return (offset + ALIGN - 1) / ALIGN * ALIGN;
+	};
+
+	size_t offset = aligned(sizeof(header_t));
+	for(index_t i = 0; i < 7; i++)
+	{
+		h.offset[i] = offset;
+		offset = aligned(offset + sizes[i]);
+	}
+
+	ofstream os(file, ios::binary);
+	if(!os) return false;
+
+	char padding[ALIGN];
+	memset(padding, 0, sizeof(padding));
+
+	os.write((char *) &h, sizeof(header_t));
+	offset = sizeof(header_t);
+
+	for(index_t i = 0; i < 7; i++)
+	{
+		os.write(padding, h.offset[i] - offset);
+		if(sizes[i]) os.write(tables[i], sizes[i]);
+		offset = h.offset[i] + sizes[i];
+	}
+
+	os.close();
+
+	return !os.fail();
+}
+
+void che_bin::delete_me()
+{
+	delete_caches();
+
+	if(mapped) unmap();
+	else che::delete_me();
+}
+
+void che_bin::unmap()
+{
+	if(!mapped) return;
+
+	munmap(mapped, mapped_size);
+	mapped = NULL;
+
+	GT = NULL;
+	VT = OT = EVT = ET = EHT = BT = NULL;
+}
+
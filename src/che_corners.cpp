@@ -0,0 +1,75 @@
+#include "che_corners.h"
+
+che_corners::che_corners(const che * mesh)
+{
+	n_vertices = mesh->n_vertices();
+	begin = new index_t[n_vertices + 1];
+	begin[0] = 0;
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	{
+		index_t n = 0;
+		for_star(he, mesh, v) n++;
+		begin[v + 1] = n;
+	}
+
+	for(index_t v = 0; v < n_vertices; v++)
+		begin[v + 1] += begin[v];
+
+	const index_t & n_corners = begin[n_vertices];
+
+	x0 = new index_t[n_corners];
+	x1 = new index_t[n_corners];
+	Q00 = new real_t[n_corners];
+	Q01 = new real_t[n_corners];
+	Q11 = new real_t[n_corners];
+	n0 = new real_t[n_corners];
+	n1 = new real_t[n_corners];
+	w = new vertex[mesh->n_half_edges()];
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	{
+		index_t k = begin[v];
+		for_star(he, mesh, v)
+		{
+			x0[k] = mesh->vt(next(he));
+			x1[k] = mesh->vt(prev(he));
+
+			vertex X0 = mesh->gt(x0[k]) - mesh->gt(v);
+			vertex X1 = mesh->gt(x1[k]) - mesh->gt(v);
+
+			real_t q00 = (X0, X0);
+			real_t q01 = (X0, X1);
+			real_t q11 = (X1, X1);
+			real_t det = q00 * q11 - q01 * q01;
+
+			Q00[k] = q11 / det;
+			Q01[k] = -q01 / det;
+			Q11[k] = q00 / det;
+			n0[k] = *X0;
+			n1[k] = *X1;
+
+			k++;
+		}
+	}
+
+	#pragma omp parallel for
+	for(index_t he = 0; he < mesh->n_half_edges(); he++)
+		w[he] = mesh->normal_he(he) * (mesh->gt_vt(prev(he)) - mesh->gt_vt(next(he)));
+}
+
+che_corners::~che_corners()
+{
+	delete [] begin;
+	delete [] x0;
+	delete [] x1;
+	delete [] Q00;
+	delete [] Q01;
+	delete [] Q11;
+	delete [] n0;
+	delete [] n1;
+	delete [] w;
+}
+
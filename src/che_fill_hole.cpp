@@ -59,7 +59,7 @@ che * mesh_simple_fill_hole(che * mesh, const vector<index_t> & border_vertices,
 	return fill_hole_front_angles(vertices, mesh->mean_edge(), normal, max_iter);
 }
 
-che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const size_t & max_iter, const vector<pair<index_t, index_t> > & split_indices = {})
+che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const size_t & max_iter, const distance_t & mean_edge, const vector<pair<index_t, index_t> > & split_indices = {})
 {
 	vector<vertex> vertices[2];
 	vector<index_t> merge_vertices[2];
@@ -73,7 +73,6 @@ che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const
 	index_t * vmap_border = new index_t[size];
 
 	index_t c = 1;
-	distance_t mean_edge = mesh->mean_edge();
 
 	auto gen_vertices = [&mean_edge](vector<index_t> & merge_vertices, vector<vertex> & vertices, const vertex & va, const vertex & vb, const index_t & delta_v = 0)
 	{
@@ -170,7 +169,7 @@ che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const
 		}
 		normal /= vertices[c].size();
 
-		hole = fill_hole_front_angles(vertices[c], mesh->mean_edge(), normal, max_iter);
+		hole = fill_hole_front_angles(vertices[c], mean_edge, normal, max_iter);
 	}
 	else
 	{
@@ -187,7 +186,7 @@ che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const
 		normal /= n_v;
 
 		aux_hole = NULL;
-		aux_hole = fill_hole_front_angles(vertices[c], mesh->mean_edge(), normal, max_iter);
+		aux_hole = fill_hole_front_angles(vertices[c], mean_edge, normal, max_iter);
 
 		hole->merge(aux_hole, merge_vertices[!c]);
 		hole->set_head_vertices(vmap_border, size);
@@ -199,6 +198,7 @@ che * mesh_fill_hole(che * mesh, const vector<index_t> & border_vertices, const
 
 	if(hole && !hole->is_manifold())
 	{
+		#pragma omp critical
 		hole->write_file(PATH_TEST + "fill_holes/fatal_error.off");
 		delete hole;
 		return NULL;
@@ -263,10 +263,13 @@ vector<index_t> * fill_all_holes(che * mesh, const size_t & max_iter)
 	vector<index_t> * border_vertices;
 	che ** holes;
 
+	// the merge closes the borders, n_borders changes
+	const size_t n_borders = mesh->n_borders();
+
 	tie(border_vertices, holes) = fill_all_holes_meshes(mesh, max_iter);
 	if(holes)
 	{
-		for(index_t b = 0; b < mesh->n_borders(); b++)
+		for(index_t b = 0; b < n_borders; b++)
 			if(holes[b]) delete holes[b];
 	}
 	delete [] holes;
@@ -286,31 +289,21 @@ tuple<vector<index_t> *, che **> fill_all_holes_meshes(che * mesh, const size_t
 
 	debug_me(inpainting)
 
-	for(index_t b = 0; b < n_borders; b++)
-		mesh->border(border_vertices[b], b);
+	const distance_t mean_edge = mesh->mean_edge();
 
-	debug_me(inpainting)
+	// the holes are independent, each border is triangulated by a thread
+	#pragma omp parallel for schedule(dynamic)
 	for(index_t b = 0; b < n_borders; b++)
 	{
-		debug(b)
-//		vector<pair<index_t, index_t> > split_indices;
-//		split_border(split_indices, mesh, border_vertices[b]);
-//		holes[b] = mesh_fill_hole(mesh, border_vertices[b], max_iter, { {77, 106}, {67, 106}, {38, 11} });
-		holes[b] = mesh_fill_hole(mesh, border_vertices[b], max_iter);
-	debug_me(inpainting)
+		mesh->border(border_vertices[b], b);
+		holes[b] = mesh_fill_hole(mesh, border_vertices[b], max_iter, mean_edge);
 		//holes[b]->write_file(PATH_TEST + string("fill_holes/partial") + "_" + to_string(b) + "_" + mesh->name() + ".off");
-	debug_me(inpainting)
 	}
 
 	debug_me(inpainting)
-	for(index_t b = 0; b < n_borders; b++)
-		if(holes[b])
-		{
-	debug_me(inpainting)
-			mesh->merge(holes[b], border_vertices[b]);
-	debug_me(inpainting)
-		}
 
+	// one rebuild of the mesh with all the holes
+	mesh->merge(holes, border_vertices, n_borders);
 
 	debug(mesh->n_borders())
 	return make_tuple(border_vertices, holes);
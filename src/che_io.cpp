@@ -0,0 +1,19 @@
+#include "che_io.h"
+
+#include "che_off.h"
+#include "che_bin.h"
+#include "che_ply.h"
+#include "che_obj.h"
+
+che * load_mesh(const string & file)
+{
+	size_t pos = file.find_last_of('.');
+	string extension = pos != string::npos ? file.substr(pos + 1) : "";
+
+	if(extension == "che") return new che_bin(file);
+	if(extension == "ply") return new che_ply(file);
+	if(extension == "obj") return new che_obj(file);
+
+	return new che_off(file);
+}
+
@@ -0,0 +1,138 @@
+#include "che_obj.h"
+
+#include "mapped_file.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cassert>
+
+che_obj::che_obj(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f)
+{
+	init(vertices, n_v, faces, n_f);
+}
+
+che_obj::che_obj(const size_t & n_v, const size_t & n_f)
+{
+	init(n_v, n_f);
+}
+
+che_obj::che_obj(const string & file)
+{
+	init(file);
+}
+
+che_obj::~che_obj()
+{
+
+}
+
+void che_obj::read_file(const string & file)
+{
+	mapped_file mf(file);
+	if(!mf.size) return;
+
+	const char * end = mf.data + mf.size;
+
+	vector<size_t> lines;
+	mf.split_lines(lines);
+
+	// 'v' vertex line, 'f' face line with n_trigs[l] triangles, 0 other lines (vt, vn, g, usemtl, ...)
+	vector<char> type(lines.size());
+	vector<index_t> n_trigs(lines.size());
+
+	#pragma omp parallel for
+	for(index_t l = 0; l < lines.size(); l++)
+	{
+		const char * p = skip_spaces(mf.data + lines[l], end);
+
+		type[l] = 0;
+		if((*p == 'v' || *p == 'f') && p + 1 < end && (p[1] == ' ' || p[1] == '\t'))
+			type[l] = *p;
+
+		if(type[l] != 'f') continue;
+
+		index_t n = 0;
+		for(p = skip_spaces(p + 1, end); p < end && *p != '\n'; p = skip_spaces(skip_token(p, end), end))
+			n++;
+
+		n_trigs[l] = n > 2 ? n - 2 : 0;
+	}
+
+	// lines of the vertices and faces, a face stores the number of previous vertices for relative indices
+	vector<size_t> vlines, flines;
+	vector<index_t> n_prev;
+
+	index_t * trig = new index_t[lines.size() + 1];
+	trig[0] = 0;
+
+	for(index_t l = 0; l < lines.size(); l++)
+	{
+		if(type[l] == 'v') vlines.push_back(lines[l]);
+		if(type[l] == 'f')
+		{
+			trig[flines.size() + 1] = trig[flines.size()] + n_trigs[l];
+			flines.push_back(lines[l]);
+			n_prev.push_back(vlines.size());
+		}
+	}
+
+	init(vlines.size(), trig[flines.size()]);
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+	{
+		const char * q = parse_vertex(mf.data + vlines[v] + 1, end, &GT[v].x);
+		assert(q);
+	}
+
+	#pragma omp parallel for
+	for(index_t f = 0; f < flines.size(); f++)
+	{
+		const char * q = skip_spaces(mf.data + flines[f], end) + 1;
+		index_t idx[3];
+		long long i;
+
+		// divide face: fan of triangles from the first vertex, v/vt/vn only v is read
+		index_t k = 0;
+		for(index_t he = che::P * trig[f]; he < che::P * trig[f + 1]; k++)
+		{
+			q = parse_number(q, end, i);
+			assert(q && i);
+
+			idx[k > 1 ? 2 : k] = i > 0 ? i - 1 : n_prev[f] + i;
+			q = skip_token(q, end);
+
+			if(k < 2) continue;
+
+			VT[he++] = idx[0];
+			VT[he++] = idx[1];
+			VT[he++] = idx[2];
+			idx[1] = idx[2];
+		}
+	}
+
+	delete [] trig;
+}
+
+void che_obj::write_file(const string & file) const
+{
+	ofstream os(file);
+
+	os << "# OBJ generated by gproshan" << endl;
+	os << "# vertices " << n_vertices_ << endl;
+	os << "# faces " << n_faces_ << endl;
+
+	for(size_t v = 0; v < n_vertices_; v++)
+		os << "v " << GT[v] << endl;
+
+	for(index_t he = 0; he < n_half_edges_; he++)
+	{
+		if(!(he % che::P)) os << "f";
+		os << " " << VT[he] + 1;
+		if(he % che::P == che::P - 1) os << endl;
+	}
+
+	os.close();
+}
+
@@ -1,5 +1,7 @@
 #include "che_off.h"
 
+#include "mapped_file.h"
+
 #include <fstream>
 #include <vector>
 #include <cstring>
@@ -27,53 +29,79 @@ che_off::~che_off()
 
 void che_off::read_file(const string & file)
 {
-	string soff;
-	size_t n_v, n_f, v;
+	mapped_file mf(file);
+	if(!mf.size) return;
 
-	ifstream is(file);
+	const char * end = mf.data + mf.size;
 
-	assert(is.good());
+	vector<size_t> lines;
+	mf.split_lines(lines);
 
-	is >> soff;
-	is >> n_v >> n_f >> v;
-	init(n_v, n_f);
+	assert(lines.size());
+
+	// header: [C|N|...]OFF, the sizes can follow in the same line
+	const char * p = skip_token(mf.data + lines[0], end);
+	index_t l = 1;
+
+	size_t n_v = 0, n_f = 0;
+	if(!(p = parse_number(p, end, n_v)))
+		p = parse_number(mf.data + lines[l++], end, n_v);
+	p = parse_number(p, end, n_f);
+
+	assert(p && lines.size() >= l + n_v + n_f);
+
+	const size_t * vlines = lines.data() + l;
+	const size_t * flines = vlines + n_v;
+
+	// number of triangles of the polygon fan of each face
+	index_t * trig = new index_t[n_f + 1];
+	trig[0] = 0;
 
-	int r, g, b, a;
-	for(index_t i = 0; i < n_vertices_; i++)
+	#pragma omp parallel for
+	for(index_t f = 0; f < n_f; f++)
 	{
-		is >> GT[i];
-		if(soff[0] == 'C') // COFF file, ignore RGBA
-			is >> r >> g >> b >> a;
+		index_t v = 0;
+		parse_number(mf.data + flines[f], end, v);
+		trig[f + 1] = v > 2 ? v - 2 : 0;
 	}
 
-	index_t he = 0;
-	for(index_t i = 0; i < n_faces_; i++)
-	{
-		is>>v;
-		if(!i && v > che::P)
-		{
-			vertex * tGT = GT; GT = NULL;
+	for(index_t f = 0; f < n_f; f++)
+		trig[f + 1] += trig[f];
 
-			delete_me();
-			init(n_v, n_f * (v - che::P + 1));
+	init(n_v, trig[n_f]);
 
-			GT = tGT;
-		}
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+	{
+		// COFF files: the RGBA color after the coordinates is ignored
+		const char * q = parse_vertex(mf.data + vlines[v], end, &GT[v].x);
+		assert(q);
+	}
+
+	#pragma omp parallel for
+	for(index_t f = 0; f < n_f; f++)
+	{
+		const char * q = mf.data + flines[f];
+		index_t v, a, b, c;
 
-		for(index_t j = 0; j < v; j++)
-			is>>VT[he++];
+		q = parse_number(q, end, v);
+		q = parse_number(q, end, a);
+		q = parse_number(q, end, b);
 
-		// divide face
-		if(v > che::P)
+		// divide face: fan of triangles (a, b, c) from the first vertex
+		for(index_t he = che::P * trig[f]; he < che::P * trig[f + 1]; he += che::P)
 		{
-			VT[he++] = VT[he - v - 1];
-			VT[he++] = VT[he - v];
+			q = parse_number(q, end, c);
+			assert(q);
 
-			i += (v - che::P);
+			VT[he] = a;
+			VT[he + 1] = b;
+			VT[he + 2] = c;
+			b = c;
 		}
 	}
 
-	is.close();
+	delete [] trig;
 }
 
 void che_off::write_file(const string & file) const
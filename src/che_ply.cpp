@@ -0,0 +1,383 @@
+#include "che_ply.h"
+
+#include "mapped_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+struct ply_property_t
+{
+	string name;
+	size_t type;				///< size in bytes of the value, 0 if the property is not read.
+	bool integer;
+	bool is_signed;
+	size_t list_type;			///< size in bytes of the list size, 0 if it is not a list.
+};
+
+struct ply_element_t
+{
+	string name;
+	size_t n;
+	vector<ply_property_t> properties;
+};
+
+/// Size in bytes of a PLY scalar type, returns false for an unknown type.
+static bool ply_type(const string & type, size_t & size, bool & integer, bool & is_signed)
+{
+	size = 0;
+	integer = true;
+	is_signed = type[0] != 'u';
+
+	if(type == "char" || type == "int8" || type == "uchar" || type == "uint8") size = 1;
+	else if(type == "short" || type == "int16" || type == "ushort" || type == "uint16") size = 2;
+	else if(type == "int" || type == "int32" || type == "uint" || type == "uint32") size = 4;
+	else
+	{
+		integer = false;
+		is_signed = true;
+
+		if(type == "float" || type == "float32") size = 4;
+		else if(type == "double" || type == "float64") size = 8;
+		else return false;
+	}
+
+	return true;
+}
+
+/// Read a binary value of size bytes, swap the bytes if the file and the host endianness differ.
+static double ply_value(const char * p, const size_t & size, const bool & integer, const bool & is_signed, const bool & swap)
+{
+	char b[8];
+	memcpy(b, p, size);
+	if(swap) reverse(b, b + size);
+
+	if(!integer)
+	{
+		if(size == 4) { float x; memcpy(&x, b, 4); return x; }
+		double x; memcpy(&x, b, 8); return x;
+	}
+
+	switch(size)
+	{
+		case 1: return is_signed ? (double) *((int8_t *) b) : (double) *((uint8_t *) b);
+		case 2: return is_signed ? (double) *((int16_t *) b) : (double) *((uint16_t *) b);
+		case 4: return is_signed ? (double) *((int32_t *) b) : (double) *((uint32_t *) b);
+	}
+
+	return 0;
+}
+
+che_ply::che_ply(const vertex * vertices, const size_t & n_v, const index_t * faces, const size_t & n_f)
+{
+	init(vertices, n_v, faces, n_f);
+}
+
+che_ply::che_ply(const size_t & n_v, const size_t & n_f)
+{
+	init(n_v, n_f);
+}
+
+che_ply::che_ply(const string & file)
+{
+	init(file);
+}
+
+che_ply::~che_ply()
+{
+
+}
+
+void che_ply::read_file(const string & file)
+{
+	mapped_file mf(file);
+	if(!mf.size) return;
+
+	const char * end = mf.data + mf.size;
+
+	// header
+	const char * h = (const char *) memmem(mf.data, mf.size, "end_header", 10);
+	if(!h)
+	{
+		cerr << "Error: " << file << ": no PLY header" << endl;
+		return;
+	}
+
+	const char * eol = (const char *) memchr(h, '\n', end - h);
+	size_t begin = eol ? eol - mf.data + 1 : mf.size;
+
+	string format;
+	vector<ply_element_t> elements;
+
+	stringstream ss(string(mf.data, h));
+	string line, type;
+	bool known = true;
+	while(getline(ss, line))
+	{
+		string str;
+		stringstream ls(line);
+		ls >> str;
+
+		if(str == "format") ls >> format;
+		else if(str == "element")
+		{
+			elements.emplace_back();
+			ls >> elements.back().name >> elements.back().n;
+		}
+		else if(str == "property")
+		{
+			assert(elements.size());
+
+			ply_property_t p;
+			bool integer, is_signed;
+
+			ls >> type;
+			p.list_type = 0;
+			if(type == "list")
+			{
+				ls >> type;
+				if(!(known = ply_type(type, p.list_type, integer, is_signed) && integer)) break;
+				ls >> type;
+			}
+
+			if(!(known = ply_type(type, p.type, p.integer, p.is_signed))) break;
+			ls >> p.name;
+
+			elements.back().properties.push_back(p);
+		}
+	}
+
+	if(!known)
+	{
+		cerr << "Error: " << file << ": unknown PLY type " << type << endl;
+		return;
+	}
+
+	const uint16_t one = 1;
+	bool ascii = format == "ascii";
+	bool swap = (format == "binary_big_endian") == *((char *) &one);
+
+	assert(ascii || format == "binary_little_endian" || format == "binary_big_endian");
+
+	ply_element_t * ev = NULL;
+	ply_element_t * ef = NULL;
+	index_t xyz[3] = {NIL, NIL, NIL};				// property index of x, y, z
+	index_t vi = NIL;								// property index of vertex_indices
+
+	for(ply_element_t & e: elements)
+	{
+		if(e.name == "vertex")
+		{
+			ev = &e;
+			for(index_t i = 0; i < e.properties.size(); i++)
+				if(e.properties[i].name.size() == 1 && e.properties[i].name[0] >= 'x' && e.properties[i].name[0] <= 'z')
+					xyz[e.properties[i].name[0] - 'x'] = i;
+		}
+
+		if(e.name == "face")
+		{
+			ef = &e;
+			for(index_t i = 0; i < e.properties.size(); i++)
+				if(e.properties[i].list_type && (e.properties[i].name == "vertex_indices" || e.properties[i].name == "vertex_index"))
+					vi = i;
+		}
+	}
+
+	assert(ev && ef && xyz[0] != NIL && xyz[1] != NIL && xyz[2] != NIL && vi != NIL);
+
+	// position of each vertex and each face in the file, the beginning of the line in ascii files
+	vector<size_t> vpos(ev->n), fpos(ef->n);
+
+	if(ascii)
+	{
+		vector<size_t> lines;
+		mf.split_lines(lines, begin);
+
+		size_t l = 0;
+		for(ply_element_t & e: elements)
+		{
+			assert(l + e.n <= lines.size());
+
+			if(&e == ev) copy(lines.begin() + l, lines.begin() + l + e.n, vpos.begin());
+			if(&e == ef) copy(lines.begin() + l, lines.begin() + l + e.n, fpos.begin());
+			l += e.n;
+		}
+	}
+	else
+	{
+		size_t pos = begin;
+		for(ply_element_t & e: elements)
+		{
+			// size of the elements without lists
+			size_t size = 0;
+			for(const ply_property_t & p: e.properties)
+			{
+				if(p.list_type) { size = 0; break; }
+				size += p.type;
+			}
+
+			if(size)
+			{
+				if(&e == ev)
+					for(index_t i = 0; i < e.n; i++)
+						vpos[i] = pos + i * size;
+
+				pos += size * e.n;
+				continue;
+			}
+
+			// elements with lists are walked sequentially, reading only the sizes of the lists
+			for(index_t i = 0; i < e.n; i++)
+			{
+				if(&e == ev) vpos[i] = pos;
+				if(&e == ef) fpos[i] = pos;
+
+				for(const ply_property_t & p: e.properties)
+				{
+					if(p.list_type)
+					{
+						assert(pos + p.list_type <= mf.size);
+						pos += p.list_type + p.type * (size_t) ply_value(mf.data + pos, p.list_type, true, false, swap);
+					}
+					else pos += p.type;
+				}
+			}
+		}
+
+		assert(pos <= mf.size);
+	}
+
+	// offset in bytes (binary) or number of values (ascii) before a property
+	auto offset = [&](const ply_element_t * e, const index_t & k) -> size_t
+	{
+		size_t off = 0;
+		for(index_t i = 0; i < k; i++)
+		{
+			assert(!e->properties[i].list_type);
+			off += ascii ? 1 : e->properties[i].type;
+		}
+		return off;
+	};
+
+	size_t vi_off = offset(ef, vi);
+	size_t xyz_off[3] = {offset(ev, xyz[0]), offset(ev, xyz[1]), offset(ev, xyz[2])};
+	const ply_property_t & pvi = ef->properties[vi];
+
+	// number of triangles of the polygon fan of each face
+	index_t * trig = new index_t[ef->n + 1];
+	trig[0] = 0;
+
+	#pragma omp parallel for
+	for(index_t f = 0; f < ef->n; f++)
+	{
+		index_t v = 0;
+
+		if(ascii)
+		{
+			const char * q = mf.data + fpos[f];
+			for(index_t i = 0; i < vi_off; i++)
+				q = skip_token(skip_spaces(q, end), end);
+			parse_number(q, end, v);
+		}
+		else v = ply_value(mf.data + fpos[f] + vi_off, pvi.list_type, true, false, swap);
+
+		trig[f + 1] = v > 2 ? v - 2 : 0;
+	}
+
+	for(index_t f = 0; f < ef->n; f++)
+		trig[f + 1] += trig[f];
+
+	init(ev->n, trig[ef->n]);
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices_; v++)
+	{
+		if(ascii)
+		{
+			real_t x;
+			const char * q = mf.data + vpos[v];
+			for(index_t i = 0; q && i < ev->properties.size(); i++)
+			{
+				q = parse_number(q, end, x);
+				if(i == xyz[0]) GT[v].x = x;
+				if(i == xyz[1]) GT[v].y = x;
+				if(i == xyz[2]) GT[v].z = x;
+			}
+		}
+		else for(index_t k = 0; k < 3; k++)
+		{
+			const ply_property_t & p = ev->properties[xyz[k]];
+			GT[v][k] = ply_value(mf.data + vpos[v] + xyz_off[k], p.type, p.integer, p.is_signed, swap);
+		}
+	}
+
+	#pragma omp parallel for
+	for(index_t f = 0; f < ef->n; f++)
+	{
+		index_t idx[3];
+		index_t k = 0;
+
+		const char * q = mf.data + fpos[f];
+		if(ascii)
+		{
+			for(index_t i = 0; i <= vi_off; i++)
+				q = skip_token(skip_spaces(q, end), end);
+		}
+		else q += vi_off + pvi.list_type;
+
+		// divide face: fan of triangles from the first vertex
+		for(index_t he = che::P * trig[f]; he < che::P * trig[f + 1]; k++)
+		{
+			if(ascii) q = parse_number(q, end, idx[k > 1 ? 2 : k]);
+			else
+			{
+				idx[k > 1 ? 2 : k] = ply_value(q, pvi.type, true, pvi.is_signed, swap);
+				q += pvi.type;
+			}
+
+			if(k < 2) continue;
+
+			VT[he++] = idx[0];
+			VT[he++] = idx[1];
+			VT[he++] = idx[2];
+			idx[1] = idx[2];
+		}
+	}
+
+	delete [] trig;
+}
+
+void che_ply::write_file(const string & file) const
+{
+	const uint16_t one = 1;
+
+	ofstream os(file, ios::binary);
+
+	os << "ply" << endl;
+	os << "format " << (*((char *) &one) ? "binary_little_endian" : "binary_big_endian") << " 1.0" << endl;
+	os << "comment gproshan" << endl;
+	os << "element vertex " << n_vertices_ << endl;
+	os << "property " << (sizeof(real_t) == 4 ? "float" : "double") << " x" << endl;
+	os << "property " << (sizeof(real_t) == 4 ? "float" : "double") << " y" << endl;
+	os << "property " << (sizeof(real_t) == 4 ? "float" : "double") << " z" << endl;
+	os << "element face " << n_faces_ << endl;
+	os << "property list uchar uint vertex_indices" << endl;
+	os << "end_header" << endl;
+
+	os.write((char *) GT, n_vertices_ * sizeof(vertex));
+
+	const unsigned char p = che::P;
+	for(index_t he = 0; he < n_half_edges_; he += che::P)
+	{
+		os.write((char *) &p, 1);
+		os.write((char *) (VT + he), che::P * sizeof(index_t));
+	}
+
+	os.close();
+}
+
@@ -1,96 +1,367 @@
 #include "che_poisson.h"
 #include "laplacian.h"
+#include "heat_flow.h"
 
 #include "include_arma.h"
 
-void poisson(che * mesh, const size_t & old_n_vertices, index_t k)
+#include <algorithm>
+
+/// Solves the rows [n_known, n) of X, the known rows are the boundary conditions.
+static void poisson_solve(a_mat & X, const a_sp_mat & L, const a_vec & areas, const size_t & n_known, const index_t & k, const real_t & tol, const size_t & max_iter)
 {
-	if(!k) return;
+	size_t n_vertices = X.n_rows;
+
+	// the unknowns are [n_known, n_vertices)
+	const index_t u0 = n_known;
+	const index_t u1 = n_vertices - 1;
+
+	// Y = L (A L)^(k-1) X, the matrix powers are not formed
+	auto apply = [&](a_mat & Y, const a_mat & V)
+	{
+		Y = L * V;
+		for(index_t i = 1; i < k; i++)
+			Y = L * (Y.each_col() % areas);
+	};
+
+	a_mat Y;
+	X.rows(u0, u1).zeros();
+
+	// the known vertices move to the right-hand side
+	apply(Y, X);
+	a_mat B = - Y.rows(u0, u1);
+
+	// operator restricted to the unknowns
+	a_mat T(n_vertices, 3, arma::fill::zeros);
+	auto apply_uu = [&](a_mat & Yu, const a_mat & Xu)
+	{
+		T.rows(u0, u1) = Xu;
+		apply(Y, T);
+		Yu = Y.rows(u0, u1);
+	};
+
+	// preconditioner: (L_UU (A_UU L_UU)^(k-1))^-1 with the cholmod factorization of L_UU
+	a_sp_mat Luu = L.submat(u0, u0, u1, u1);
+	a_vec areas_u = areas.subvec(u0, u1);
+
+	cholmod_common context;
+	cholmod_l_start(&context);
+
+	cholmod_sparse cL = cholmod_view(Luu);
+	cL.stype = 1;
+
+	cholmod_factor * F = cholmod_l_analyze(&cL, &context);
+	cholmod_l_factorize(&cL, F, &context);
+
+	a_mat b(Luu.n_rows, 3);
+	cholmod_dense * W = NULL, * E = NULL;
 
-	a_mat B(mesh->n_vertices(), 3);
-	for(index_t v = 0; v < mesh->n_vertices(); v++)
+	auto precond = [&](a_mat & Z, const a_mat & R)
 	{
-		if(v < old_n_vertices)
+		Z.set_size(R.n_rows, R.n_cols);
+
+		cholmod_dense cb = cholmod_view(b);
+		cholmod_dense cz = cholmod_view(Z);
+		cholmod_dense * pz = &cz;
+
+		b = R;
+		for(index_t i = 0; i < k; i++)
 		{
-			B(v, 0) = mesh->gt(v).x;
-			B(v, 1) = mesh->gt(v).y;
-			B(v, 2) = mesh->gt(v).z;
+			if(i) b = Z.each_col() / areas_u;
+			cholmod_l_solve2(CHOLMOD_A, F, &cb, NULL, &pz, NULL, &W, &E, &context);
 		}
-		else B.row(v).zeros();
+	};
+
+	// preconditioned conjugate gradient, the three coordinates at the same time
+	a_mat Xu(Luu.n_rows, 3, arma::fill::zeros);
+	a_mat R = B, Z, P, Q;
+	a_rowvec rz, beta, alpha, b_norm = sqrt(sum(square(B)));
+
+	// a converged coordinate (e.g. a planar hole) has 0 / 0 steps
+	auto finite = [](a_rowvec & x)
+	{
+		x.transform([](const real_t & val) { return isfinite(val) ? val : 0; });
+	};
+
+	precond(Z, R);
+	P = Z;
+	rz = sum(R % Z);
+
+	index_t it = 0;
+	for(; it < max_iter && any(sqrt(sum(square(R))) > tol * b_norm); it++)
+	{
+		apply_uu(Q, P);
+
+		alpha = rz / sum(P % Q);
+		finite(alpha);
+
+		Xu += P.each_row() % alpha;
+		R -= Q.each_row() % alpha;
+
+		precond(Z, R);
+
+		beta = 1 / rz;
+		rz = sum(R % Z);
+		beta %= rz;
+		finite(beta);
+
+		P = Z + P.each_row() % beta;
 	}
 
+	debug(it)
+
+	cholmod_l_free_factor(&F, &context);
+	cholmod_l_free_dense(&W, &context);
+	cholmod_l_free_dense(&E, &context);
+	cholmod_l_finish(&context);
+
+	X.rows(u0, u1) = Xu;
+}
+
+void poisson(che * mesh, const size_t & old_n_vertices, index_t k, const real_t & tol, const size_t & max_iter)
+{
+	if(!k) return;
+
+	size_t n_vertices = mesh->n_vertices();
+	if(n_vertices == old_n_vertices) return;
+
 	a_sp_mat L, A;
 	laplacian(mesh, L, A);
 
-	for(index_t i = 0; i < mesh->n_vertices(); i++)
-		B.row(i) *= -1 / A(i,i);
+	a_mat X(n_vertices, 3);
+	for(index_t v = 0; v < old_n_vertices; v++)
+	{
+		X(v, 0) = mesh->gt(v).x;
+		X(v, 1) = mesh->gt(v).y;
+		X(v, 2) = mesh->gt(v).z;
+	}
 
-	a_sp_mat M;
-	real_t s = (k % 2) ? -1 : 1;
+	poisson_solve(X, L, a_vec(A.diag()), old_n_vertices, k, tol, max_iter);
 
-	if(k > 1) M = A * L;
-	while(--k) L *= M;
+	for(index_t v = old_n_vertices; v < n_vertices; v++)
+	{
+		mesh->get_vertex(v).x = X(v, 0);
+		mesh->get_vertex(v).y = X(v, 1);
+		mesh->get_vertex(v).z = X(v, 2);
+	}
 
-	for(index_t v = 0; v < old_n_vertices; v++)
+	mesh->update_geometry();
+}
+
+void poisson_local(che * mesh, const size_t & old_n_vertices, index_t k, const real_t & tol, const size_t & max_iter)
+{
+	if(!k) return;
+
+	size_t n_vertices = mesh->n_vertices();
+	if(n_vertices == old_n_vertices) return;
+
+	// rings 0..k of the new vertices: the rows of L (AL)^(k-1) of the new vertices only reach them
+	vector<index_t> sources;
+	for(index_t v = old_n_vertices; v < n_vertices; v++)
+		sources.push_back(v);
+
+	index_t * rings = new index_t[n_vertices];
+	index_t * sorted = new index_t[n_vertices];
+	vector<index_t> limites;
+	mesh->compute_toplesets(rings, sorted, limites, sources, k);
+
+	// local order: the known vertices of the region, then the new vertices
+	vector<index_t> vertices;
+	for(index_t i = 0; i < limites.back(); i++)
+		if(sorted[i] < old_n_vertices)
+			vertices.push_back(sorted[i]);
+
+	size_t n_known = vertices.size();
+	vertices.insert(vertices.end(), sources.begin(), sources.end());
+
+	delete [] rings;
+	delete [] sorted;
+
+	// the rows of the vertices of the ring k are incomplete, they do not reach the new vertices
+	a_sp_mat L;
+	a_vec areas;
+	laplacian(mesh, vertices, L, areas);
+
+	a_mat X(vertices.size(), 3);
+	for(index_t i = 0; i < n_known; i++)
 	{
-		B.col(0) -= mesh->gt(v).x * L.col(v);
-		B.col(1) -= mesh->gt(v).y * L.col(v);
-		B.col(2) -= mesh->gt(v).z * L.col(v);
+		X(i, 0) = mesh->gt(vertices[i]).x;
+		X(i, 1) = mesh->gt(vertices[i]).y;
+		X(i, 2) = mesh->gt(vertices[i]).z;
 	}
 
-	L.shed_cols(0, old_n_vertices - 1);
-	L.shed_rows(0, old_n_vertices - 1);
-	A.shed_rows(0, old_n_vertices - 1);
-	A.shed_cols(0, old_n_vertices - 1);
-	B.shed_rows(0, old_n_vertices - 1);
+	poisson_solve(X, L, areas, n_known, k, tol, max_iter);
 
-	a_mat X;
-	if(spsolve(X, s * L, s * B))
-	for(index_t v = old_n_vertices; v < mesh->n_vertices(); v++)
+	for(index_t i = n_known; i < vertices.size(); i++)
 	{
-		mesh->get_vertex(v).x = X(v - old_n_vertices, 0);
-		mesh->get_vertex(v).y = X(v - old_n_vertices, 1);
-		mesh->get_vertex(v).z = X(v - old_n_vertices, 2);
+		mesh->get_vertex(vertices[i]).x = X(i, 0);
+		mesh->get_vertex(vertices[i]).y = X(i, 1);
+		mesh->get_vertex(vertices[i]).z = X(i, 2);
 	}
+
+	mesh->update_geometry();
 }
 
-void biharmonic_interp_2(a_mat & P, a_mat & H)
+biharmonic_spline_2::biharmonic_spline_2(const a_mat & P_, const real_t & radio_): P(P_.rows(0, 1)), radio(radio_), z_mean(0)
 {
-	size_t n = P.n_cols;
-	real_t x;
+	const size_t n = P.n_cols;
 
-	a_mat A(n, n);
-	a_vec pi(2), pj(2);
+	cholmod_l_start(&context);
 
-	for(index_t i = 0; i < n; i++)
+	if(radio <= 0)
 	{
-		pi(0) = P(0, i); pi(1) = P(1, i);
+		a_mat A(n, n);
+
+		#pragma omp parallel for
+		for(index_t j = 0; j < n; j++)
+		for(index_t i = 0; i <= j; i++)
+			A(i, j) = A(j, i) = kernel(norm(P.col(i) - P.col(j)));
+
+		lu(L, U, Pr, A);
+	}
+	else
+	{
+		for(index_t i = 0; i < n; i++)
+			grid[cell(P(0, i), P(1, i))].push_back(i);
+
+		// column j has the centers in the support of j, sorted to assemble the csc matrix
+		vector<vector<pair<index_t, real_t> > > cols(n);
+
+		#pragma omp parallel for
+		for(index_t j = 0; j < n; j++)
+		{
+			vector<index_t> centers;
+			support(centers, P(0, j), P(1, j));
+
+			real_t r;
+			for(const index_t & i: centers)
+				if((r = norm(P.col(i) - P.col(j))) < radio)
+					cols[j].push_back({i, kernel(r)});
+
+			sort(cols[j].begin(), cols[j].end());
+		}
+
+		arma::uvec col_ptrs(n + 1);
+		col_ptrs(0) = 0;
 		for(index_t j = 0; j < n; j++)
+			col_ptrs(j + 1) = col_ptrs(j) + cols[j].size();
+
+		arma::uvec row_indices(col_ptrs(n));
+		a_vec values(col_ptrs(n));
+
+		#pragma omp parallel for
+		for(index_t j = 0; j < n; j++)
+		for(index_t k = 0; k < cols[j].size(); k++)
 		{
-			pj(0) = P(0, j); pj(1) = P(1, j);
-			x = norm(pi - pj);
-			A(i, j) = x * x * (log(x + 1e-18) - 1);
+			row_indices(col_ptrs(j) + k) = cols[j][k].first;
+			values(col_ptrs(j) + k) = cols[j][k].second;
 		}
+
+		a_sp_mat K(row_indices, col_ptrs, values, n, n);
+
+		cholmod_sparse cK = cholmod_view(K);
+		cK.stype = 1;
+
+		F = cholmod_l_analyze(&cK, &context);
+		cholmod_l_factorize(&cK, F, &context);
 	}
 
-	a_mat alpha = solve(A, P.row(2).t());
+	if(P_.n_rows > 2) fit(P_.row(2).t());
+}
+
+biharmonic_spline_2::~biharmonic_spline_2()
+{
+	cholmod_l_free_factor(&F, &context);
+	cholmod_l_finish(&context);
+}
 
-	for(index_t i = 0; i < H.n_cols; i++)
+void biharmonic_spline_2::fit(const a_vec & z)
+{
+	if(!F)
 	{
-		H(2, i) = 0;
-		pi(0) = H(0, i); pi(1) = H(1, i);
-		for(index_t j = 0; j < n; j++)
+		alpha = solve(trimatu(U), solve(trimatl(L), Pr * z));
+		return;
+	}
+
+	// the compact support fits the variation from the mean height
+	z_mean = mean(z);
+	a_vec b = z - z_mean;
+	alpha.set_size(b.n_elem);
+
+	cholmod_dense cb = cholmod_view(b);
+	cholmod_dense cx = cholmod_view(alpha);
+	cholmod_dense * px = &cx, * W = NULL, * E = NULL;
+
+	cholmod_l_solve2(CHOLMOD_A, F, &cb, NULL, &px, NULL, &W, &E, &context);
+
+	cholmod_l_free_dense(&W, &context);
+	cholmod_l_free_dense(&E, &context);
+}
+
+void biharmonic_spline_2::eval(a_mat & H) const
+{
+	#pragma omp parallel
+	{
+		vector<index_t> centers;
+		a_vec p(2);
+
+		#pragma omp for
+		for(index_t h = 0; h < H.n_cols; h++)
 		{
-			pj(0) = P(0, j); pj(1) = P(1, j);
-			x = norm(pi - pj);
-			x *= x * (log(x + 1e-18) - 1);
-			H(2, i) += alpha(j, 0) * x;
+			p(0) = H(0, h); p(1) = H(1, h);
+
+			real_t z = z_mean, r;
+			if(!F)
+			{
+				for(index_t i = 0; i < P.n_cols; i++)
+					z += alpha(i) * kernel(norm(p - P.col(i)));
+			}
+			else
+			{
+				support(centers, p(0), p(1));
+				for(const index_t & i: centers)
+					if((r = norm(p - P.col(i))) < radio)
+						z += alpha(i) * kernel(r);
+			}
+
+			H(2, h) = z;
 		}
 	}
 }
 
+real_t biharmonic_spline_2::kernel(const real_t & r) const
+{
+	if(radio <= 0) return r * r * (log(r + 1e-18) - 1);
+
+	const real_t t = 1 - r / radio;
+	return t * t * t * t * (4 * r / radio + 1);
+}
+
+uint64_t biharmonic_spline_2::cell(const real_t & x, const real_t & y) const
+{
+	return (uint64_t(uint32_t(int32_t(floor(x / radio)))) << 32) | uint32_t(int32_t(floor(y / radio)));
+}
+
+void biharmonic_spline_2::support(vector<index_t> & centers, const real_t & x, const real_t & y) const
+{
+	centers.clear();
+
+	for(int dx = -1; dx <= 1; dx++)
+	for(int dy = -1; dy <= 1; dy++)
+	{
+		auto it = grid.find(cell(x + dx * radio, y + dy * radio));
+		if(it != grid.end())
+			centers.insert(centers.end(), it->second.begin(), it->second.end());
+	}
+}
+
+void biharmonic_interp_2(a_mat & P, a_mat & H, const real_t & radio)
+{
+	biharmonic_spline_2 spline(P, radio);
+	spline.eval(H);
+}
+
 //fill one hole and fit with biharmonic_interp_2
-void biharmonic_interp_2(che * mesh, const size_t & old_n_vertices, const size_t & n_vertices, const vector<index_t> & border_vertices, const index_t & k)
+void biharmonic_interp_2(che * mesh, const size_t & old_n_vertices, const size_t & n_vertices, const vector<index_t> & border_vertices, const index_t & k, const size_t & dense_max)
 {
 	if(old_n_vertices == n_vertices) return;
 
@@ -144,7 +415,22 @@ void biharmonic_interp_2(che * mesh, const size_t & old_n_vertices, const size_t
 	P = E.t() * P;
 	H = E.t() * H;
 
-	biharmonic_interp_2(P, H);
+	// support of some rings of the mean edge around the border
+	real_t radio = 0;
+	if(P.n_cols > dense_max)
+	{
+		size_t n_edges = 0;
+		for(const index_t & b: sub_mesh_hole)
+			for_star(he, mesh, b)
+			{
+				radio += *(mesh->gt(mesh->vt(next(he))) - mesh->gt(b));
+				n_edges++;
+			}
+
+		radio = 8 * radio / n_edges;
+	}
+
+	biharmonic_interp_2(P, H, radio);
 
 	H = E * H;
 	H.each_col() += avg;
@@ -154,6 +154,12 @@ distance_t farthest_point_sampling_ptp_gpu(che * mesh, vector<index_t> & samples
 	return max_dist;
 }
 
+bool cuda_device_available()
+{
+	int n_devices = 0;
+	return cudaGetDeviceCount(&n_devices) == cudaSuccess && n_devices > 0;
+}
+
 index_t run_ptp_gpu(CHE * d_mesh, const index_t & n_vertices, distance_t * h_dist, distance_t ** d_dist, const vector<index_t> & sources, const vector<index_t> & limits, const index_t * h_sorted, index_t * d_sorted, index_t * h_clusters, index_t ** d_clusters)
 {
 	#pragma omp parallel for
@@ -0,0 +1,93 @@
+#include "descriptor.h"
+
+#include "laplacian.h"
+
+descriptor::descriptor(const signature & sig, che * mesh, const size_t & K, const size_t & T)
+{
+	a_sp_mat L, A;
+	if(!eigs_laplacian(eigval, eigvec, L, A, mesh, K))
+		return;
+
+	switch(sig)
+	{
+		case GPS: compute_gps();
+			break;
+		case HKS: compute_hks(T);
+			break;
+		case WKS: compute_wks(T);
+			break;
+	}
+}
+
+descriptor::operator bool() const
+{
+	return features.n_elem > 0;
+}
+
+real_t descriptor::operator()(const index_t & v) const
+{
+	return norm(features.row(v));
+}
+
+const a_mat & descriptor::matrix() const
+{
+	return features;
+}
+
+bool descriptor::save(const string & file) const
+{
+	return features.save(file, arma::arma_binary);
+}
+
+void descriptor::compute_gps()
+{
+	// the first eigenvector is constant
+	features = eigvec.tail_cols(eigvec.n_cols - 1);
+	features.each_row() /= sqrt(abs(eigval.tail(eigval.n_elem - 1))).t();
+}
+
+void descriptor::compute_hks(const size_t & T)
+{
+	// times in [4 ln(10) / lambda_K, 4 ln(10) / lambda_1], skipping the constant eigenvector
+	a_vec lambda = abs(eigval.tail(eigval.n_elem - 1));
+
+	real_t log_t_min = log(4 * log(10) / lambda.max());
+	real_t log_t_max = log(4 * log(10) / lambda.min());
+
+	a_mat F(lambda.n_elem, T);
+
+	#pragma omp parallel for
+	for(index_t t = 0; t < T; t++)
+	{
+		real_t time = exp(log_t_min + (log_t_max - log_t_min) * t / max(T - 1, (size_t) 1));
+		F.col(t) = exp(- time * lambda);
+	}
+
+	features = square(eigvec.tail_cols(lambda.n_elem)) * F;
+}
+
+void descriptor::compute_wks(const size_t & T)
+{
+	// energies log(lambda) with gaussian filters of variance sigma^2, skipping the constant eigenvector
+	a_vec log_lambda = log(abs(eigval.tail(eigval.n_elem - 1)));
+
+	real_t e_min = log_lambda.min();
+	real_t e_max = log_lambda.max();
+	real_t sigma = 7 * (e_max - e_min) / T;
+
+	e_min += 2 * sigma;
+	e_max -= 2 * sigma;
+
+	a_mat F(log_lambda.n_elem, T);
+
+	#pragma omp parallel for
+	for(index_t t = 0; t < T; t++)
+	{
+		real_t e = e_min + (e_max - e_min) * t / max(T - 1, (size_t) 1);
+		F.col(t) = exp(- square(e - log_lambda) / (2 * sigma * sigma));
+		F.col(t) /= accu(F.col(t));
+	}
+
+	features = square(eigvec.tail_cols(log_lambda.n_elem)) * F;
+}
+
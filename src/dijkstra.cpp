@@ -1,28 +1,63 @@
 #include "dijkstra.h"
 
+#include <queue>
 #include <cstring>
 #include <cmath>
+#include <cassert>
 
-dijkstra::dijkstra(che * shape, index_t src)
+#include <omp.h>
+
+// visit the neighbors u of v over the edges of the mesh, the link of v
+#define for_neighbor(u, shape, v)	for_star(he_v, shape, v) \
+									for(index_t k = 0, u = shape->vt(next(he_v)); k < 2; k++, u = shape->vt(prev(he_v))) \
+										if(!k || shape->ot(prev(he_v)) == NIL)
+
+/// Atomic x = min(x, v), returns true if x was updated (OpenMP 5.1 atomic compare, gcc >= 12).
+static bool atomic_min(distance_t & x, const distance_t & v)
+{
+	distance_t old;
+
+	#pragma omp atomic compare capture
+	{ old = x; if(v < x) { x = v; } }
+
+	return v < old;
+}
+
+dijkstra::dijkstra(che * shape, index_t src): dijkstra(shape, vector<index_t>{src})
+{
+}
+
+dijkstra::dijkstra(che * shape, const vector<index_t> & srcs, const option_t & opt, const distance_t & radio, const index_t & target, distance_t delta)
 {
 	n_vertices = shape->n_vertices();
-	source = src;
+	sources = srcs;
+
+	assert(sources.size() > 0);
 
 	weights = new distance_t[n_vertices];
 	predecessors = new index_t[n_vertices];
 
-	memset(predecessors, 255, sizeof(distance_t)*n_vertices);
+	memset(predecessors, 255, sizeof(index_t) * n_vertices);
 
+	#pragma omp parallel for
 	for(index_t i = 0; i < n_vertices; i++)
 		weights[i] = INFINITY;
 
-	run(shape);
+	for(index_t s: sources)
+		weights[s] = 0;
+
+	if(opt == DELTA_STEPPING)
+	{
+		if(delta <= 0) delta = shape->mean_edge();
+		run_delta_stepping(shape, radio, target, delta);
+	}
+	else run_heap(shape, radio, target);
 }
 
 dijkstra::~dijkstra()
 {
-	if(weights)	delete weights;
-	if(predecessors) delete predecessors;
+	delete [] weights;
+	delete [] predecessors;
 }
 
 distance_t & dijkstra::operator()(index_t i)
@@ -41,57 +76,134 @@ void dijkstra::print(ostream & os)
 		os<<weights[i]<<endl;
 }
 
-void dijkstra::run(che * shape)
+void dijkstra::run_heap(che * shape, const distance_t & radio, const index_t & target)
 {
-	bool * visited = new bool[n_vertices];
-	memset(visited, 0, sizeof(bool)*n_vertices);
+	priority_queue<pair<distance_t, index_t>,
+			vector<pair<distance_t, index_t> >,
+			greater<pair<distance_t, index_t> > > q;
 
-	visited[source] = true;
-	weights[source] = 0;
+	for(index_t s: sources)
+		q.push(make_pair(0, s));
 
-	distance_t min;
-	index_t min_i;
+	distance_t d, w;
+	index_t v;
 
-	for(index_t i = 0; i < n_vertices; i++)
+	while(!q.empty())
 	{
-		min = INFINITY;
-		min_i = NIL;
+		d = q.top().first;
+		v = q.top().second;
+		q.pop();
+
+		if(d > weights[v]) continue;		// old entry of v
 
-		#pragma	omp parallel for num_threads(8)
-		for(index_t v = 0; v < n_vertices; v++)
+		if(d > radio || v == target)
 		{
-			distance_t w;
-			index_t nv;
+			clear_farther(min(d, radio));
+			return;
+		}
 
-			if(!visited[v])
+		for_neighbor(u, shape, v)
+		{
+			w = d + *(shape->gt(u) - shape->gt(v));
+			if(w < weights[u])
 			{
-				link_t link_he;
-				shape->link(link_he, v);
+				weights[u] = w;
+				predecessors[u] = v;
+				q.push(make_pair(w, u));
+			}
+		}
+	}
+}
+
+void dijkstra::run_delta_stepping(che * shape, const distance_t & radio, const index_t & target, const distance_t & delta)
+{
+	// bucket b has the vertices with weights in [b * delta, (b + 1) * delta), it can have old entries
+	vector<vector<index_t> > buckets(1, sources);
+	vector<index_t> current;
 
-				for(index_t he: link_he)
+	auto bucket = [&delta](const distance_t & d) -> index_t
+	{
+		return d / delta;
+	};
+
+	distance_t stop = radio;
+	for(index_t b = 0; b < buckets.size() && b * delta <= stop; b++)
+	{
+		// all the edges are relaxed in each phase, an improved vertex can be added again to bucket b
+		while(buckets[b].size())
+		{
+			current.swap(buckets[b]);
+			buckets[b].clear();
+
+			vector<index_t> improved;
+
+			#pragma omp parallel
+			{
+				vector<index_t> local;
+
+				#pragma omp for nowait
+				for(index_t i = 0; i < current.size(); i++)
 				{
-					nv = shape->vt(next(he));
+					const index_t & v = current[i];
 
-					if(visited[nv])
-					{
-						w = weights[nv] + *(shape->get_vertex(nv) - shape->get_vertex(v));
+					distance_t wv;
+					#pragma omp atomic read
+					wv = weights[v];
+					if(bucket(wv) != b) continue;			// old entry of v
 
-						if(w < weights[v])
-							weights[v] = w;
-					}
+					for_neighbor(u, shape, v)
+						if(atomic_min(weights[u], wv + *(shape->gt(u) - shape->gt(v))))
+							local.push_back(u);
 				}
 
 				#pragma omp critical
-				if(weights[v] < min)
-				{
-					min = weights[v];
-					min_i = v;
-				}
+				improved.insert(improved.end(), local.begin(), local.end());
 			}
+
+			for(const index_t & u: improved)
+			{
+				index_t ub = bucket(weights[u]);
+				if(ub >= buckets.size()) buckets.resize(ub + 1);
+				buckets[ub].push_back(u);
+			}
+		}
+
+		if(target != NIL && weights[target] < (b + 1) * delta)
+		{
+			stop = weights[target];
+			break;
 		}
+	}
+
+	if(stop < INFINITY) clear_farther(stop);
+
+	// predecessors from the final weights: the neighbor giving the shortest path
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	{
+		if(weights[v] == INFINITY || !weights[v]) continue;
 
-		if(min_i != NIL) visited[min_i] = true;
+		distance_t min_w = INFINITY, w;
+		for_neighbor(u, shape, v)
+		{
+			w = weights[u] + *(shape->gt(u) - shape->gt(v));
+			if(w < min_w)
+			{
+				min_w = w;
+				predecessors[v] = u;
+			}
+		}
 	}
+}
 
-	delete visited;
+void dijkstra::clear_farther(const distance_t & d)
+{
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+		if(weights[v] > d)
+		{
+			weights[v] = INFINITY;
+			predecessors[v] = NIL;
+		}
 }
+
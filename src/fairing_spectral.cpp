@@ -14,11 +14,6 @@ void fairing_spectral::compute(che * shape)
 {
 	double time;
 
-	a_sp_mat L, A;
-
-	TIC(time) laplacian(shape, L, A); TOC(time)
-	debug(time)
-
 	positions = new vertex[shape->n_vertices()];
 
 	a_mat X((real_t *) positions, 3, shape->n_vertices(), false, true);
@@ -27,12 +22,14 @@ void fairing_spectral::compute(che * shape)
 	for(index_t v = 0; v < shape->n_vertices(); v++)
 		positions[v] = shape->gt(v);
 
+	a_sp_mat L, A;
 	a_vec eigval;
 	a_mat eigvec;
 
-	TIC(time) k = eigs_laplacian(eigval, eigvec, shape, L, k); TOC(time)
+	TIC(time) k = eigs_laplacian(eigval, eigvec, L, A, shape, k); TOC(time)
 	debug(time)
 
-	X = X * eigvec * eigvec.t();
+	// projection onto the A-orthonormal eigenvectors
+	X = X * A * eigvec * eigvec.t();
 }
 
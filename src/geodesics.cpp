@@ -8,7 +8,7 @@
 
 #define DP 5e-2
 
-geodesics::geodesics(che * mesh, const vector<index_t> & sources, const option_t & opt, const bool & cluster, const size_t & n_iter, const distance_t & radio)
+geodesics::geodesics(che * mesh, const vector<index_t> & sources, const option_t & opt, const bool & cluster, const size_t & n_iter, const distance_t & radio, const distance_t & tol)
 {
 	n_vertices = mesh->n_vertices();
 	assert(n_vertices > 0);
@@ -26,7 +26,7 @@ geodesics::geodesics(che * mesh, const vector<index_t> & sources, const option_t
 		distances[v] = INFINITY;
 
 	assert(sources.size() > 0);
-	execute(mesh, sources, n_iter, radio, opt);
+	execute(mesh, sources, n_iter, radio, tol, opt);
 }
 
 geodesics::~geodesics()
@@ -86,7 +86,7 @@ void geodesics::normalize()
 		distances[sorted_index[i]] /= max;
 }
 
-void geodesics::execute(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio, const option_t & opt)
+void geodesics::execute(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio, const distance_t & tol, const option_t & opt)
 {
 	switch(opt)
 	{
@@ -100,6 +100,8 @@ void geodesics::execute(che * mesh, const vector<index_t> & sources, const size_
 			break;
 		case HEAT_FLOW_GPU: run_heat_flow_gpu(mesh, sources);
 			break;
+		case PTP_CPU_ACTIVE: run_parallel_toplesets_propagation_active_cpu(mesh, sources, tol);
+			break;
 	}
 }
 
@@ -124,6 +126,8 @@ void geodesics::run_fastmarching(che * mesh, const vector<index_t> & sources, co
 
 	size_t black_i, v;
 
+	const che_corners * table = clusters ? NULL : &mesh->corners();
+
 	index_t c = 0;
 	n_sorted = 0;
 	for(index_t s: sources)
@@ -160,7 +164,8 @@ void geodesics::run_fastmarching(che * mesh, const vector<index_t> & sources, co
 
 			if(color[v] == RED)
 			{
-				for_star(v_he, mesh, v)
+				if(table) distances[v] = min(distances[v], update_star(*table, distances, v));
+				else for_star(v_he, mesh, v)
 				{
 					//p = update(d, mesh, v_he, vx);
 					p = update_step(mesh, distances, v_he);
@@ -199,6 +204,23 @@ void geodesics::run_parallel_toplesets_propagation_cpu(che * mesh, const vector<
 	delete [] toplesets;
 }
 
+void geodesics::run_parallel_toplesets_propagation_active_cpu(che * mesh, const vector<index_t> & sources, const distance_t & tol)
+{
+	if(distances) delete [] distances;
+
+	index_t * toplesets = new index_t[n_vertices];
+	vector<index_t> limits;
+	mesh->compute_toplesets(toplesets, sorted_index, limits, sources);
+
+	double time_ptp;
+	TIC(time_ptp)
+	distances = parallel_toplesets_propagation_active_cpu(mesh, sources, limits, sorted_index, tol, clusters);
+	TOC(time_ptp)
+	debug(time_ptp)
+
+	delete [] toplesets;
+}
+
 void geodesics::run_parallel_toplesets_propagation_gpu(che * mesh, const vector<index_t> & sources, const size_t & n_iter, const distance_t & radio)
 {
 	if(distances) delete [] distances;
@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+#include <omp.h>
+
 index_t iterations(const vector<index_t> & limits)
 {
 	return limits.size() << 1;
@@ -31,6 +33,8 @@ distance_t * parallel_toplesets_propagation_cpu(che * mesh, const vector<index_t
 		if(clusters) clusters[sources[i]] = i + 1;
 	}
 
+	const che_corners * table = clusters ? NULL : &mesh->corners();
+
 	index_t d = 1;
 	index_t start, end;
 	index_t iter = iterations(limits);
@@ -45,6 +49,12 @@ distance_t * parallel_toplesets_propagation_cpu(che * mesh, const vector<index_t
 			const index_t & v = sorted_index[vi];
 			dist[!d][v] = dist[d][v];
 
+			if(table)
+			{
+				dist[!d][v] = min(dist[!d][v], update_star(*table, dist[d], v));
+				continue;
+			}
+
 			distance_t p;
 			for_star(he, mesh, v)
 			{
@@ -65,6 +75,252 @@ distance_t * parallel_toplesets_propagation_cpu(che * mesh, const vector<index_t
 	return dist[!d];
 }
 
+distance_t * parallel_toplesets_propagation_active_cpu(che * mesh, const vector<index_t> & sources, const vector<index_t> & limits, const index_t * sorted_index, const distance_t & tol, index_t * clusters, ptp_stats_t * stats)
+{
+	distance_t * dist[2] = {new distance_t[mesh->n_vertices()], new distance_t[mesh->n_vertices()]};
+	index_t * dirty = new index_t[mesh->n_vertices()];		// iteration in which the vertex must be recomputed
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < mesh->n_vertices(); v++)
+	{
+		dist[0][v] = dist[1][v] = INFINITY;
+		dirty[v] = 0;
+	}
+
+	for(index_t i = 0; i < sources.size(); i++)
+	{
+		dist[0][sources[i]] = dist[1][sources[i]] = 0;
+		if(clusters) clusters[sources[i]] = i + 1;
+	}
+
+	const che_corners * table = clusters ? NULL : &mesh->corners();
+
+	index_t d = 1;
+	index_t start, end, prev_end = 0;
+	index_t iter = iterations(limits);
+	index_t i = 2;
+	size_t relaxations = 0;
+
+	for(; i < iter; i++)
+	{
+		start = start_v(i, limits);
+		end = end_v(i, limits);
+
+		index_t n_changed = 0;
+
+		#pragma omp parallel for reduction(+: n_changed, relaxations)
+		for(index_t vi = start; vi < end; vi++)
+		{
+			const index_t & v = sorted_index[vi];
+			dist[!d][v] = dist[d][v];
+
+			// the neighbors did not change: the same result as the last time
+			index_t dirty_v;
+			#pragma omp atomic read
+			dirty_v = dirty[v];
+
+			if(vi < prev_end && dirty_v < i) continue;
+
+			if(table)
+			{
+				dist[!d][v] = min(dist[!d][v], update_star(*table, dist[d], v));
+				relaxations += table->begin[v + 1] - table->begin[v];
+			}
+			else
+			{
+				distance_t p;
+				for_star(he, mesh, v)
+				{
+					p = update_step(mesh, dist[d], he);
+					relaxations++;
+
+					if(p < dist[!d][v])
+					{
+						dist[!d][v] = p;
+						if(clusters)
+							clusters[v] = clusters[mesh->vt(prev(he))] != NIL ? clusters[mesh->vt(prev(he))] : clusters[mesh->vt(next(he))];
+					}
+				}
+			}
+
+			if(dist[!d][v] < dist[d][v] && (dist[d][v] == INFINITY || dist[d][v] - dist[!d][v] > tol * dist[d][v]))
+			{
+				n_changed++;
+				for_star(he, mesh, v)
+				{
+					#pragma omp atomic write
+					dirty[mesh->vt(next(he))] = i + 1;
+					#pragma omp atomic write
+					dirty[mesh->vt(prev(he))] = i + 1;
+				}
+			}
+		}
+
+		prev_end = max(prev_end, end);
+		d = !d;
+
+		if(!n_changed && end == limits.back()) break;
+	}
+
+	if(stats)
+	{
+		stats->iterations = i < iter ? i - 1 : iter - 2;
+		stats->relaxations = relaxations;
+	}
+
+	// the same buffer as parallel_toplesets_propagation_cpu (an even number of iterations), at the
+	// break nothing changed in the last window then both buffers have the same distances
+	delete [] dirty;
+	delete [] dist[1];
+	return dist[0];
+}
+
+distance_t farthest_point_sampling_ptp_cpu(che * mesh, vector<index_t> & samples, double & time_fps, size_t n, distance_t radio)
+{
+	debug_me(GEODESICS_PTP)
+
+	TIC(time_fps)
+
+	const size_t & n_vertices = mesh->n_vertices();
+
+	// relative tolerance to keep a vertex in the front, the distances are not the exact fixed point
+	const distance_t tol = 1e-6;
+
+	distance_t * dist = new distance_t[n_vertices];
+	distance_t * candidate = new distance_t[n_vertices];
+	index_t * stamp = new index_t[n_vertices];
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	{
+		dist[v] = INFINITY;
+		stamp[v] = 0;
+	}
+
+	vector<index_t> front, next;
+	index_t iter = 0;
+
+	// only the region where the new sources are closer than the current distances is relaxed,
+	// the front are the vertices updated in the last iteration
+	auto add_sources = [&](const vector<index_t> & sources)
+	{
+		front.clear();
+		for(index_t s: sources)
+		{
+			dist[s] = 0;
+			front.push_back(s);
+		}
+
+		while(front.size())
+		{
+			iter++;
+			next.clear();
+
+			#pragma omp parallel
+			{
+				vector<index_t> local;
+				link_t v_link;
+
+				#pragma omp for nowait
+				for(index_t i = 0; i < front.size(); i++)
+				{
+					v_link.clear();
+					mesh->link(v_link, front[i]);
+					for(index_t he: v_link)
+					{
+						const index_t & v = mesh->vt(he);
+						index_t old;
+
+						#pragma omp atomic capture
+						{ old = stamp[v]; stamp[v] = iter; }
+
+						if(old != iter) local.push_back(v);
+					}
+				}
+
+				#pragma omp critical
+				next.insert(next.end(), local.begin(), local.end());
+			}
+
+			#pragma omp parallel for
+			for(index_t i = 0; i < next.size(); i++)
+			{
+				const index_t & v = next[i];
+				candidate[i] = dist[v];
+
+				distance_t p;
+				for_star(he, mesh, v)
+				{
+					p = update_step(mesh, dist, he);
+					if(p < candidate[i]) candidate[i] = p;
+				}
+			}
+
+			front.clear();
+			for(index_t i = 0; i < next.size(); i++)
+				if(candidate[i] < dist[next[i]] * (1 - tol))
+				{
+					dist[next[i]] = candidate[i];
+					front.push_back(next[i]);
+				}
+		}
+	};
+
+	if(n >= n_vertices) n = n_vertices >> 1;
+
+	n -= samples.size();
+	samples.reserve(n);
+
+	add_sources(samples);
+
+	distance_t max_dist = INFINITY;
+	while(n-- && max_dist > radio)
+	{
+		index_t f = 0;
+		max_dist = 0;
+
+		#pragma omp parallel
+		{
+			index_t lf = 0;
+			distance_t lmax = 0;
+
+			#pragma omp for nowait
+			for(index_t v = 0; v < n_vertices; v++)
+				if(dist[v] < INFINITY && dist[v] > lmax)
+				{
+					lmax = dist[v];
+					lf = v;
+				}
+
+			#pragma omp critical
+			if(lmax > max_dist || (lmax == max_dist && lf < f))
+			{
+				max_dist = lmax;
+				f = lf;
+			}
+		}
+
+		samples.push_back(f);
+		add_sources({f});
+	}
+
+	delete [] dist;
+	delete [] candidate;
+	delete [] stamp;
+
+	TOC(time_fps)
+
+	return max_dist;
+}
+
+distance_t farthest_point_sampling_ptp(che * mesh, vector<index_t> & samples, double & time_fps, size_t n, distance_t radio)
+{
+	if(cuda_device_available())
+		return farthest_point_sampling_ptp_gpu(mesh, samples, time_fps, n, radio);
+
+	return farthest_point_sampling_ptp_cpu(mesh, samples, time_fps, n, radio);
+}
+
 distance_t update_step(che * mesh, const distance_t * dist, const index_t & he)
 {
 	index_t x[3];
@@ -132,6 +388,41 @@ distance_t update_step(che * mesh, const distance_t * dist, const index_t & he)
 	return p;
 }
 
+distance_t update_star(const che_corners & table, const distance_t * dist, const index_t & v)
+{
+	distance_t p_min = INFINITY;
+
+	// same computation as update_step, the condition Q * X^T * n < 0 is simplified to Q * (t - p) < 0
+	#pragma omp simd reduction(min: p_min)
+	for(index_t k = table.begin[v]; k < table.begin[v + 1]; k++)
+	{
+		const distance_t t0 = dist[table.x0[k]];
+		const distance_t t1 = dist[table.x1[k]];
+		const distance_t Q00 = table.Q00[k];
+		const distance_t Q01 = table.Q01[k];
+		const distance_t Q11 = table.Q11[k];
+
+		const distance_t sQ = Q00 + 2 * Q01 + Q11;
+		const distance_t delta = t0 * (Q00 + Q01) + t1 * (Q01 + Q11);
+		const distance_t dis = delta * delta - sQ * (t0 * t0 * Q00 + 2 * t0 * t1 * Q01 + t1 * t1 * Q11 - 1);
+
+		distance_t p = (delta + sqrt(dis >= 0 ? dis : 0)) / sQ;
+
+		const distance_t c0 = Q00 * (t0 - p) + Q01 * (t1 - p);
+		const distance_t c1 = Q01 * (t0 - p) + Q11 * (t1 - p);
+
+		const distance_t dp0 = t0 + table.n0[k];
+		const distance_t dp1 = t1 + table.n1[k];
+
+		const bool planar = t0 < INFINITY && t1 < INFINITY && dis >= 0 && c0 < 0 && c1 < 0;
+		p = planar ? p : (dp1 < dp0 ? dp1 : dp0);
+
+		p_min = p < p_min ? p : p_min;
+	}
+
+	return p_min;
+}
+
 void normalize_ptp(distance_t * dist, const size_t & n)
 {
 	distance_t max_d = 0;
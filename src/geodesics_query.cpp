@@ -0,0 +1,263 @@
+#include "geodesics_query.h"
+#include "geodesics_ptp.h"
+
+#include <queue>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include <omp.h>
+
+geodesics_query::geodesics_query(che * _mesh): mesh(_mesh)
+{
+	n_vertices = mesh->n_vertices();
+	assert(n_vertices > 0);
+
+	scratch.resize(omp_get_max_threads());
+	for(scratch_t & s: scratch)
+	{
+		s.dist = s.dist_ptp = NULL;
+		s.stamp = NULL;
+		s.epoch = 1;
+	}
+}
+
+geodesics_query::~geodesics_query()
+{
+	for(scratch_t & s: scratch)
+	{
+		delete [] s.dist;
+		delete [] s.dist_ptp;
+		delete [] s.stamp;
+	}
+}
+
+const geodesics_query::scratch_t & geodesics_query::query(const vector<index_t> & sources, const distance_t & radio, const geodesics::option_t & opt, const size_t & n_iter)
+{
+	assert(sources.size() > 0);
+
+	scratch_t & s = thread_scratch();
+	reset(s);
+
+	switch(opt)
+	{
+		case geodesics::FM: run_fastmarching(s, sources, radio, n_iter);
+			break;
+		case geodesics::PTP_CPU: run_parallel_toplesets_propagation(s, sources, radio);
+			break;
+		default: assert(false);
+	}
+
+	return s;
+}
+
+void geodesics_query::batch(vector<vector<index_t> > & sorted, const vector<index_t> & sources, const distance_t & radio, const geodesics::option_t & opt)
+{
+	sorted.resize(sources.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for(index_t i = 0; i < sources.size(); i++)
+		sorted[i] = query({sources[i]}, radio, opt).sorted;
+}
+
+geodesics_query::scratch_t & geodesics_query::thread_scratch()
+{
+	assert(omp_get_thread_num() < scratch.size());
+	scratch_t & s = scratch[omp_get_thread_num()];
+
+	if(!s.dist)
+	{
+		s.dist = new distance_t[n_vertices];
+		s.stamp = new index_t[n_vertices];
+
+		for(index_t v = 0; v < n_vertices; v++)
+			s.dist[v] = INFINITY;
+
+		memset(s.stamp, 0, n_vertices * sizeof(index_t));
+	}
+
+	return s;
+}
+
+void geodesics_query::reset(scratch_t & s)
+{
+	for(const index_t & v: s.touched)
+	{
+		s.dist[v] = INFINITY;
+		if(s.dist_ptp) s.dist_ptp[v] = INFINITY;
+	}
+
+	s.touched.clear();
+	s.sorted.clear();
+
+	// a new epoch marks all the vertices as not visited, the stamps are cleared only on overflow
+	s.epoch += 2;
+	if(s.epoch >= NIL - 1)
+	{
+		memset(s.stamp, 0, n_vertices * sizeof(index_t));
+		s.epoch = 1;
+	}
+}
+
+void geodesics_query::run_fastmarching(scratch_t & s, const vector<index_t> & sources, const distance_t & radio, const size_t & n_iter)
+{
+	const index_t RED = s.epoch, BLACK = s.epoch + 1;
+
+	size_t black_count = n_iter ? n_iter : n_vertices;
+
+	priority_queue<pair<distance_t, index_t>,
+			vector<pair<distance_t, index_t> >,
+			greater<pair<distance_t, index_t> > > front;
+
+	for(index_t v: sources)
+	{
+		s.dist[v] = 0;
+		s.stamp[v] = RED;
+		s.touched.push_back(v);
+		front.push(make_pair(0, v));
+	}
+
+	index_t black_i, v;
+	distance_t p;
+
+	while(black_count-- && !front.empty())
+	{
+		while(!front.empty() && s.stamp[front.top().second] == BLACK)
+			front.pop();
+
+		if(front.empty()) break;
+
+		black_i = front.top().second;
+		s.stamp[black_i] = BLACK;
+		front.pop();
+
+		if(s.dist[black_i] > radio) break;
+
+		s.sorted.push_back(black_i);
+
+		s.link.clear();
+		mesh->link(s.link, black_i);
+		for(index_t he: s.link)
+		{
+			v = mesh->vt(he);
+
+			if(s.stamp[v] < RED)
+				s.stamp[v] = RED;
+
+			if(s.stamp[v] == RED)
+			{
+				if(s.dist[v] == INFINITY)
+					s.touched.push_back(v);
+
+				for_star(v_he, mesh, v)
+				{
+					p = update_step(mesh, s.dist, v_he);
+					if(p < s.dist[v]) s.dist[v] = p;
+				}
+
+				if(s.dist[v] < INFINITY)
+					front.push(make_pair(s.dist[v], v));
+			}
+		}
+	}
+}
+
+void geodesics_query::run_parallel_toplesets_propagation(scratch_t & s, const vector<index_t> & sources, const distance_t & radio)
+{
+	if(!s.dist_ptp)
+	{
+		s.dist_ptp = new distance_t[n_vertices];
+		for(index_t v = 0; v < n_vertices; v++)
+			s.dist_ptp[v] = INFINITY;
+	}
+
+	const index_t VISITED = s.epoch;
+
+	// a vertex within the radio is reached by a path of vertices within the radio, and the
+	// euclidean distance to the closest source is a lower bound of the geodesic distance
+	auto in_ball = [&](const index_t & v) -> bool
+	{
+		if(radio == INFINITY) return true;
+
+		for(const index_t & src: sources)
+			if(*(mesh->gt(v) - mesh->gt(src)) <= radio) return true;
+		return false;
+	};
+
+	// local toplesets: BFS over the region of the vertices in the ball
+	s.toplesets.clear();
+	s.limits.clear();
+	s.limits.push_back(0);
+
+	for(index_t v: sources)
+		if(s.stamp[v] != VISITED)
+		{
+			s.stamp[v] = VISITED;
+			s.toplesets.push_back(v);
+		}
+
+	s.limits.push_back(s.toplesets.size());
+
+	for(index_t level = 1; s.limits[level - 1] < s.limits[level]; level++)
+	{
+		for(index_t i = s.limits[level - 1]; i < s.limits[level]; i++)
+		{
+			s.link.clear();
+			mesh->link(s.link, s.toplesets[i]);
+			for(index_t he: s.link)
+			{
+				const index_t & v = mesh->vt(he);
+				if(s.stamp[v] != VISITED && in_ball(v))
+				{
+					s.stamp[v] = VISITED;
+					s.toplesets.push_back(v);
+				}
+			}
+		}
+
+		s.limits.push_back(s.toplesets.size());
+	}
+
+	s.limits.pop_back();
+	s.touched = s.toplesets;
+
+	distance_t * dist[2] = {s.dist, s.dist_ptp};
+	for(index_t v: sources)
+		dist[0][v] = dist[1][v] = 0;
+
+	// same propagation as parallel_toplesets_propagation_cpu, sequential on the local toplesets
+	index_t d = 1;
+	index_t iter = iterations(s.limits);
+	for(index_t i = 2; i < iter; i++)
+	{
+		index_t start = start_v(i, s.limits);
+		index_t end = end_v(i, s.limits);
+
+		for(index_t vi = start; vi < end; vi++)
+		{
+			const index_t & v = s.toplesets[vi];
+			dist[!d][v] = dist[d][v];
+
+			distance_t p;
+			for_star(he, mesh, v)
+			{
+				p = update_step(mesh, dist[d], he);
+				if(p < dist[!d][v]) dist[!d][v] = p;
+			}
+		}
+
+		d = !d;
+	}
+
+	s.dist = dist[d];
+	s.dist_ptp = dist[!d];
+
+	for(index_t v: s.toplesets)
+		if(s.dist[v] <= radio) s.sorted.push_back(v);
+
+	sort(s.sorted.begin(), s.sorted.end(), [&s](const index_t & a, const index_t & b) -> bool
+	{
+		return s.dist[a] < s.dist[b];
+	});
+}
+
@@ -3,57 +3,154 @@
 #include "laplacian.h"
 
 #include <cassert>
+#include <cstring>
 
-distance_t * heat_flow(che * mesh, const vector<index_t> & sources, double & solve_time)
+heat_flow_solver::heat_flow_solver(che * _mesh): mesh(_mesh)
 {
-	if(!sources.size()) return 0;
-	
-	// build impulse signal
-	a_mat u0(mesh->n_vertices(), 1, arma::fill::zeros);
-	for(auto & v: sources) u0(v) = 1;
-	
+	n_vertices = mesh->n_vertices();
+
 	// step
 	real_t dt = mesh->mean_edge();
 	dt *= dt;
 
-	a_sp_mat L, A;
-	laplacian(mesh, L, A);
-	
-	// make L positive-definite
-	L += 1.0e-8 * A;
-
-	// heat flow for short interval
-	A += dt * L;
-	a_mat u(mesh->n_vertices(), 1);
-	
-	cholmod_common context;
 	cholmod_l_start(&context);
-	
+	Y = E = NULL;
+
+	// laplacian assembled in the arrays of cholmod, no conversion, the matrix is packed then nzmax
+	// (laplacian_nnz) can be larger than the nonzeros col_ptrs[n_vertices] of a non manifold mesh
+	cholmod_sparse * L = cholmod_l_allocate_sparse(n_vertices, n_vertices, laplacian_nnz(mesh), 1, 1, 1, CHOLMOD_REAL, &context);
+	SuiteSparse_long * col_ptrs = (SuiteSparse_long *) L->p;
+	SuiteSparse_long * row_indices = (SuiteSparse_long *) L->i;
+	double * values = (double *) L->x;
+
+	double * areas = new double[n_vertices];
+	laplacian(mesh, col_ptrs, row_indices, values, areas);
+
+	cholmod_sparse * A = cholmod_l_copy_sparse(L, &context);
+	double * A_values = (double *) A->x;
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	for(SuiteSparse_long k = col_ptrs[v]; k < col_ptrs[v + 1]; k++)
+	{
+		// make L positive-definite
+		if(row_indices[k] == v) values[k] += 1.0e-8 * areas[v];
+
+		// heat flow for short interval: A + dt L
+		A_values[k] = dt * values[k];
+		if(row_indices[k] == v) A_values[k] += areas[v];
+	}
+
+	delete [] areas;
+
+	heat = factorize(A);
+	poisson = factorize(L);
+
+	cholmod_l_free_sparse(&A, &context);
+	cholmod_l_free_sparse(&L, &context);
+}
+
+heat_flow_solver::~heat_flow_solver()
+{
+	cholmod_l_free_factor(&heat, &context);
+	cholmod_l_free_factor(&poisson, &context);
+	cholmod_l_free_dense(&Y, &context);
+	cholmod_l_free_dense(&E, &context);
+	cholmod_l_finish(&context);
+}
+
+distance_t * heat_flow_solver::operator()(const vector<index_t> & sources, double & solve_time)
+{
+	if(!sources.size()) return 0;
+
+	return batch({sources}, solve_time);
+}
+
+distance_t * heat_flow_solver::batch(const vector<vector<index_t> > & sources, double & solve_time)
+{
+	if(!sources.size()) return 0;
+
+	size_t n_cols = sources.size();
+	size_t n_elem = n_vertices * n_cols;
+
+	// build impulse signals, a column by set of sources
+	real_t * u0 = new real_t[n_elem];
+	memset(u0, 0, n_elem * sizeof(real_t));
+
+	for(index_t i = 0; i < n_cols; i++)
+	for(auto & v: sources[i])
+		u0[i * n_vertices + v] = 1;
+
+	real_t * u = new real_t[n_elem];
+	real_t * div = new real_t[n_elem];
+	distance_t * distances = new distance_t[n_elem];
+
+	// the solves write into the buffers through cholmod views
+	cholmod_dense cu0 = cholmod_view(u0, n_vertices, n_cols);
+	cholmod_dense cu = cholmod_view(u, n_vertices, n_cols);
+	cholmod_dense cdiv = cholmod_view(div, n_vertices, n_cols);
+	cholmod_dense cphi = cholmod_view(distances, n_vertices, n_cols);
+
+	double time;
 	solve_time = 0;
 
-	solve_time += solve_positive_definite(u, A, u0, &context);		// cholmod (suitesparse)
-	//assert(spsolve(u, A, u0));	// arma
+	TIC(time) solve(heat, &cu0, &cu); TOC(time)
+	solve_time += time;
+
+	for(index_t i = 0; i < n_cols; i++)
+	{
+		a_mat ui(u + i * n_vertices, n_vertices, 1, false, true);
+		a_mat divi(div + i * n_vertices, n_vertices, 1, false, true);
+		compute_divergence(mesh, ui, divi);
+	}
+
+	TIC(time) solve(poisson, &cdiv, &cphi); TOC(time)
+	solve_time += time;
 
 	// extract geodesics
-	distance_t * distances = new distance_t[mesh->n_vertices()];
-	
-	a_mat div(mesh->n_vertices(), 1);
-	compute_divergence(mesh, u, div);
+	#pragma omp parallel for
+	for(index_t i = 0; i < n_cols; i++)
+	{
+		distance_t * phi = distances + i * n_vertices;
 
-	a_mat phi(distances, mesh->n_vertices(), 1, false);
+		distance_t min_val = INFINITY;
+		for(index_t v = 0; v < n_vertices; v++)
+			min_val = min(min_val, phi[v]);
 
-	solve_time += solve_positive_definite(phi, L, div, &context);	// cholmod (suitesparse)
-	//assert(spsolve(phi, L, div));	// arma
-	
-	real_t min_val = phi.min();
-	phi.for_each([&min_val](a_mat::elem_type & val) { val -= min_val; val *= 0.5; });
-	
-	//cholmod_l_gpu_stats(&context);
-	cholmod_l_finish(&context);
+		for(index_t v = 0; v < n_vertices; v++)
+			phi[v] = 0.5 * (phi[v] - min_val);
+	}
+
+	delete [] u0;
+	delete [] u;
+	delete [] div;
 
 	return distances;
 }
 
+void heat_flow_solver::solve(cholmod_factor * F, cholmod_dense * b, cholmod_dense * x)
+{
+	// the workspaces Y and E are kept between solves
+	cholmod_dense * X = x;
+	cholmod_l_solve2(CHOLMOD_A, F, b, NULL, &X, NULL, &Y, &E, &context);
+	assert(X == x);
+}
+
+cholmod_factor * heat_flow_solver::factorize(cholmod_sparse * M)
+{
+	cholmod_factor * F = cholmod_l_analyze(M, &context);
+	cholmod_l_factorize(M, F, &context);
+
+	return F;
+}
+
+distance_t * heat_flow(che * mesh, const vector<index_t> & sources, double & solve_time)
+{
+	if(!sources.size()) return 0;
+
+	return mesh->heat_solver()(sources, solve_time);
+}
+
 distance_t * heat_flow_gpu(che * mesh, const vector<index_t> & sources, double & solve_time)
 {
 	if(!sources.size()) return 0;
@@ -98,69 +195,115 @@ distance_t * heat_flow_gpu(che * mesh, const vector<index_t> & sources, double &
 
 void compute_divergence(che * mesh, const a_mat & u, a_mat & div)
 {
+	// w[he] is the rotated opposite edge of the corner he, cached by the mesh
+	const vertex * w = mesh->corners().w;
+	const distance_t * f = u.memptr();
+
+	// normalized gradient of u in each face, computed once instead of once per corner
+	vertex * g = new vertex[mesh->n_faces()];
+
+	#pragma omp parallel for
+	for(index_t t = 0; t < mesh->n_faces(); t++)
+	{
+		index_t he = t * che::P;
+		g[t] = f[mesh->vt(he)] * w[he] + f[mesh->vt(next(he))] * w[next(he)] + f[mesh->vt(prev(he))] * w[prev(he)];
+		g[t] /= *g[t];
+	}
+
+	#pragma omp parallel for
 	for(index_t v = 0; v < mesh->n_vertices(); v++)
 	{
 		real_t & sum = div(v);
 
 		sum = 0;
 		for_star(he, mesh, v)
-			sum += (
-					mesh->normal_he(he) * ( mesh->gt_vt(prev(he)) - mesh->gt_vt(next(he)) ) ,
-					- mesh->gradient_he(he, u.memptr()) 
-					);
+			sum += (w[he], - g[trig(he)]);
 	}
+
+	delete [] g;
 }
 
 double solve_positive_definite(a_mat & x, const a_sp_mat & A, const a_mat & b, cholmod_common * context)
 {
-	cholmod_sparse * cA = arma_2_cholmod(A, context);
-	cA->stype = 1;
-	
-	cholmod_dense * cb = arma_2_cholmod(b, context);
+	assert(x.n_rows == b.n_rows && x.n_cols == b.n_cols);
+
+	cholmod_sparse cA = cholmod_view(A);
+	cA.stype = 1;
+
+	cholmod_dense cb = cholmod_view(b);
+	cholmod_dense cx = cholmod_view(x);
+	cholmod_dense * X = &cx, * Y = NULL, * E = NULL;
+
+	cholmod_factor * L = cholmod_l_analyze(&cA, context);
+	cholmod_l_factorize(&cA, L, context);
 
-	cholmod_factor * L = cholmod_l_analyze(cA, context);
-	cholmod_l_factorize(cA, L, context);
-	
 	/* fill ratio
 	debug(L->xsize)
-	debug(cA->nzmax)
-	debug(L->xsize / cA->nzmax)
+	debug(cA.nzmax)
+	debug(L->xsize / cA.nzmax)
 	*/
 
 	double solve_time;
 	TIC(solve_time)
-	cholmod_dense * cx = cholmod_l_solve(CHOLMOD_A, L, cb, context);
+	cholmod_l_solve2(CHOLMOD_A, L, &cb, NULL, &X, NULL, &Y, &E, context);		// solution in x
 	TOC(solve_time)
-	
-	assert(x.n_rows == b.n_rows);
-	memcpy(x.memptr(), cx->x, x.n_rows * sizeof(real_t));
+
+	assert(X == &cx);
 
 	cholmod_l_free_factor(&L, context);
-	cholmod_l_free_sparse(&cA, context);
-	cholmod_l_free_dense(&cb, context);
+	cholmod_l_free_dense(&Y, context);
+	cholmod_l_free_dense(&E, context);
 
 	return solve_time;
 }
-	
-cholmod_dense * arma_2_cholmod(const a_mat & D, cholmod_common * context)
+
+cholmod_sparse cholmod_view(const a_sp_mat & S)
 {
-	cholmod_dense * cD = cholmod_l_allocate_dense(D.n_rows, D.n_cols, D.n_rows, CHOLMOD_REAL, context);
-	memcpy(cD->x, D.memptr(), D.n_elem * sizeof(real_t));
+	assert(sizeof(arma::uword) == sizeof(SuiteSparse_long));
+	assert(sizeof(real_t) == sizeof(double));
 
-	return cD;
+	S.sync();
+
+	cholmod_sparse cS;
+	memset(&cS, 0, sizeof(cholmod_sparse));
+
+	cS.nrow = S.n_rows;
+	cS.ncol = S.n_cols;
+	cS.nzmax = S.n_nonzero;
+	cS.p = (void *) S.col_ptrs;
+	cS.i = (void *) S.row_indices;
+	cS.x = (void *) S.values;
+	cS.stype = 0;
+	cS.itype = CHOLMOD_LONG;
+	cS.xtype = CHOLMOD_REAL;
+	cS.dtype = CHOLMOD_DOUBLE;
+	cS.sorted = 1;
+	cS.packed = 1;
+
+	return cS;
 }
 
-cholmod_sparse * arma_2_cholmod(const a_sp_mat & S, cholmod_common * context)
+cholmod_dense cholmod_view(const a_mat & D)
 {
-	assert(sizeof(arma::uword) == sizeof(SuiteSparse_long));
-	
-	cholmod_sparse * cS = cholmod_l_allocate_sparse(S.n_rows, S.n_cols, S.n_nonzero, 1, 1, 0, CHOLMOD_REAL, context);
-	
-	memcpy(cS->p, S.col_ptrs, (S.n_cols + 1) * sizeof(arma::uword));
-	memcpy(cS->i, S.row_indices, S.n_nonzero * sizeof(arma::uword));
-	memcpy(cS->x, S.values, S.n_nonzero * sizeof(real_t));
-	
-	return cS;
+	return cholmod_view((real_t *) D.memptr(), D.n_rows, D.n_cols);
+}
+
+cholmod_dense cholmod_view(real_t * x, const size_t & n_rows, const size_t & n_cols)
+{
+	assert(sizeof(real_t) == sizeof(double));
+
+	cholmod_dense cD;
+	memset(&cD, 0, sizeof(cholmod_dense));
+
+	cD.nrow = n_rows;
+	cD.ncol = n_cols;
+	cD.nzmax = n_rows * n_cols;
+	cD.d = n_rows;
+	cD.x = x;
+	cD.xtype = CHOLMOD_REAL;
+	cD.dtype = CHOLMOD_DOUBLE;
+
+	return cD;
 }
 
 double solve_positive_definite_gpu(a_mat & x, const a_sp_mat & A, const a_mat & b)
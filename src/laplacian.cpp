@@ -1,96 +1,679 @@
 #include "laplacian.h"
 
-void laplacian(che * mesh, a_sp_mat & L, a_sp_mat & A)
+#include "mapped_file.h"
+#include "heat_flow.h"
+
+#include <fstream>
+#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <cassert>
+
+#include <unistd.h>
+
+size_t laplacian_nnz(che * mesh)
+{
+	return mesh->n_vertices() + 2 * mesh->n_edges();
+}
+
+/// Calls f(u, w) for each neighbor u of v, w is the cotan weight of the edge (v, u), returns the sum of the weights.
+template<class F>
+static real_t laplacian_star(che * mesh, const index_t & v, F f)
+{
+	real_t sum = 0, w;
+	for_star(he, mesh, v)
+	{
+		// edge (v, vt(next(he))) with the angles opposite to he and ot(he)
+		w = (mesh->cotan(he) + mesh->cotan(mesh->ot(he))) / 2;
+		f(mesh->vt(next(he)), w);
+		sum += w;
+
+		// border edge (vt(prev(he)), v) only with the angle opposite to prev(he)
+		if(mesh->ot(prev(he)) == NIL)
+		{
+			w = mesh->cotan(prev(he)) / 2;
+			f(mesh->vt(prev(he)), w);
+			sum += w;
+		}
+	}
+
+	return sum;
+}
+
+/// Insertion sort of the rows of a column, the columns are small.
+template<class I, class T>
+static void sort_column(I * rows, T * vals, const I & n)
+{
+	for(I i = 1; i < n; i++)
+	for(I j = i; j > 0 && rows[j] < rows[j - 1]; j--)
+	{
+		swap(rows[j], rows[j - 1]);
+		swap(vals[j], vals[j - 1]);
+	}
+}
+
+template<class I, class T>
+size_t laplacian(che * mesh, I * col_ptrs, I * row_indices, T * values, T * areas)
 {
-	size_t n_edges = mesh->n_edges();
 	size_t n_vertices = mesh->n_vertices();
+	size_t n_edges = mesh->n_edges();
 
-	arma::umat DI(2, 2 * n_edges);
-	a_vec DV(2 * n_edges);
+	// the edges of ET (D^T S D), an edge of a non manifold mesh can be more than once in ET
+	real_t * weight = new real_t[n_edges];
+	index_t * begin = new index_t[n_vertices + 1];
+	index_t * incident = new index_t[n_edges << 1];		// edges of v: incident[begin[v] .. begin[v + 1])
 
-	arma::umat SI(2, n_edges);
-	a_vec SV(n_edges);
+	auto endpoints = [&](const index_t & e, index_t & a, index_t & b)
+	{
+		a = mesh->vt(mesh->et(e));
+		b = mesh->vt(next(mesh->et(e)));
+	};
+
+	// the other vertex of the edge e of v
+	auto neighbor = [&](const index_t & v, const index_t & e) -> index_t
+	{
+		index_t a, b;
+		endpoints(e, a, b);
+		return a == v ? b : a;
+	};
+
+	memset(begin, 0, sizeof(index_t) * (n_vertices + 1));
 
 	#pragma omp parallel for
 	for(index_t e = 0; e < n_edges; e++)
 	{
-		index_t i = e << 1;
+		weight[e] = (mesh->cotan(mesh->et(e)) + mesh->cotan(mesh->ot_et(e))) / 2;
 
-		DI(0, i) = e;
-		DI(1, i) = mesh->vt(mesh->et(e));
-		DV(i) = -1;
+		index_t a, b;
+		endpoints(e, a, b);
+		if(a == b) continue;
 
-		i++;
+		#pragma omp atomic
+		begin[a + 1]++;
+		#pragma omp atomic
+		begin[b + 1]++;
+	}
 
-		DI(0, i) = e;
-		DI(1, i) = mesh->vt(next(mesh->et(e)));
-		DV(i) = 1;
+	for(index_t v = 0; v < n_vertices; v++)
+		begin[v + 1] += begin[v];
 
-		SI(0, e) = SI(1, e) = e;
-		SV(e) = (mesh->cotan(mesh->et(e)) +
-					mesh->cotan(mesh->ot_et(e))) / 2;
+	index_t * pos = new index_t[n_vertices];
+	memcpy(pos, begin, sizeof(index_t) * n_vertices);
+
+	#pragma omp parallel for
+	for(index_t e = 0; e < n_edges; e++)
+	{
+		index_t a, b, i;
+		endpoints(e, a, b);
+		if(a == b) continue;
+
+		#pragma omp atomic capture
+		i = pos[a]++;
+		incident[i] = e;
+
+		#pragma omp atomic capture
+		i = pos[b]++;
+		incident[i] = e;
 	}
 
-	a_sp_mat D(DI, DV, n_edges, n_vertices);
-	a_sp_mat S(SI, SV, n_edges, n_edges);
+	delete [] pos;
+
+	// count pass: the edges of v sorted by neighbor (and by edge, then the sums do not depend on
+	// the threads), the column v has the diagonal and one row by different neighbor
+	col_ptrs[0] = 0;
+
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+	{
+		index_t * edges = incident + begin[v];
+		index_t n = begin[v + 1] - begin[v];
+
+		sort(edges, edges + n, [&](const index_t & e, const index_t & f)
+		{
+			index_t u = neighbor(v, e), w = neighbor(v, f);
+			return u < w || (u == w && e < f);
+		});
+
+		I n_rows = 1;
+		for(index_t i = 0; i < n; i++)
+			if(!i || neighbor(v, edges[i]) != neighbor(v, edges[i - 1])) n_rows++;
 
-	L = D.t() * S * D;
+		col_ptrs[v + 1] = n_rows;
+	}
 
-	A.eye(n_vertices, n_vertices);
+	for(index_t v = 0; v < n_vertices; v++)
+		col_ptrs[v + 1] += col_ptrs[v];
 
 	#pragma omp parallel for
 	for(index_t v = 0; v < n_vertices; v++)
-		A(v, v) = mesh->area_vertex(v);
+	{
+		I * rows = row_indices + col_ptrs[v];
+		T * vals = values + col_ptrs[v];
+		I n = 1;
+
+		rows[0] = v;
+		vals[0] = 0;
+
+		for(index_t i = begin[v]; i < begin[v + 1]; i++)
+		{
+			const index_t & e = incident[i];
+			index_t u = neighbor(v, e);
+
+			if(i == begin[v] || u != neighbor(v, incident[i - 1]))
+			{
+				rows[n] = u;
+				vals[n++] = 0;
+			}
+
+			vals[n - 1] -= weight[e];
+			vals[0] += weight[e];
+		}
+
+		sort_column(rows, vals, n);
+
+		areas[v] = mesh->area_vertex(v);
+	}
+
+	delete [] weight;
+	delete [] begin;
+	delete [] incident;
+
+	return col_ptrs[n_vertices];
+}
+
+template size_t laplacian<arma::uword, real_t>(che * mesh, arma::uword * col_ptrs, arma::uword * row_indices, real_t * values, real_t * areas);
+template size_t laplacian<int, double>(che * mesh, int * col_ptrs, int * row_indices, double * values, double * areas);
+template size_t laplacian<long, double>(che * mesh, long * col_ptrs, long * row_indices, double * values, double * areas);
+
+void laplacian(che * mesh, a_sp_mat & L, a_sp_mat & A)
+{
+	size_t n_vertices = mesh->n_vertices();
+	size_t n_nonzero = laplacian_nnz(mesh);
+
+	arma::uvec col_ptrs(n_vertices + 1);
+	arma::uvec row_indices(n_nonzero);
+	a_vec values(n_nonzero);
+	a_vec areas(n_vertices);
+
+	n_nonzero = laplacian(mesh, col_ptrs.memptr(), row_indices.memptr(), values.memptr(), areas.memptr());
+
+	L = a_sp_mat(row_indices.head(n_nonzero), col_ptrs, values.head(n_nonzero), n_vertices, n_vertices);
+
+	A.zeros(n_vertices, n_vertices);
+	A.diag() = areas;
+}
+
+void laplacian(che * mesh, const vector<index_t> & vertices, a_sp_mat & L, a_vec & areas)
+{
+	size_t n_vertices = vertices.size();
+
+	unordered_map<index_t, index_t> local;
+	for(index_t i = 0; i < n_vertices; i++)
+		local[vertices[i]] = i;
+
+	// the diagonal keeps the weights of all the edges, also of the neighbors out of the region
+	arma::uvec col_ptrs(n_vertices + 1);
+	col_ptrs(0) = 0;
+
+	#pragma omp parallel for
+	for(index_t i = 0; i < n_vertices; i++)
+	{
+		arma::uword n = 1;
+		laplacian_star(mesh, vertices[i], [&](const index_t & u, const real_t &)
+		{
+			if(local.count(u)) n++;
+		});
+
+		col_ptrs(i + 1) = n;
+	}
+
+	for(index_t i = 0; i < n_vertices; i++)
+		col_ptrs(i + 1) += col_ptrs(i);
+
+	arma::uvec row_indices(col_ptrs(n_vertices));
+	a_vec values(col_ptrs(n_vertices));
+	areas.set_size(n_vertices);
+
+	#pragma omp parallel for
+	for(index_t i = 0; i < n_vertices; i++)
+	{
+		arma::uword * rows = row_indices.memptr() + col_ptrs(i);
+		real_t * vals = values.memptr() + col_ptrs(i);
+		arma::uword n = 1;
+
+		rows[0] = i;
+		vals[0] = laplacian_star(mesh, vertices[i], [&](const index_t & u, const real_t & w)
+		{
+			auto it = local.find(u);
+			if(it == local.end()) return;
+
+			rows[n] = it->second;
+			vals[n++] = -w;
+		});
+
+		sort_column(rows, vals, n);
+
+		areas(i) = mesh->area_vertex(vertices[i]);
+	}
+
+	L = a_sp_mat(row_indices, col_ptrs, values, n_vertices, n_vertices);
 }
 
 void laplacian(che * mesh, sp_mat_e & L, sp_mat_e & A)
 {
 	debug_me(LAPLACIAN)
 
-	size_t n_edges = mesh->n_edges();
 	size_t n_vertices = mesh->n_vertices();
+	size_t n_nonzero = laplacian_nnz(mesh);
 
-	sp_mat_e D(n_edges, n_vertices);
-	sp_mat_e S(n_edges, n_edges);
+	L.resize(n_vertices, n_vertices);
+	L.resizeNonZeros(n_nonzero);
 
-	D.reserve(VectorXi::Constant(n_edges,2));
-	S.reserve(VectorXi::Constant(n_edges,1));
+	VectorXd areas(n_vertices);
 
-	for(index_t e = 0; e < n_edges; e++)
+	n_nonzero = laplacian(mesh, L.outerIndexPtr(), L.innerIndexPtr(), L.valuePtr(), areas.data());
+	L.resizeNonZeros(n_nonzero);
+
+	A.resize(n_vertices, n_vertices);
+	A.setIdentity();
+	A.diagonal() = areas;
+}
+
+uint64_t hash_mesh(che * mesh)
+{
+	// FNV-1a over 64 bits words, in a fixed number of blocks to be independent of the threads
+	const size_t n_blocks = 64;
+
+	auto hash = [](const char * data, const size_t & size, uint64_t h) -> uint64_t
+	{
+		uint64_t w;
+		size_t i = 0;
+
+		for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			memcpy(&w, data + i, sizeof(uint64_t));
+			h = (h ^ w) * 1099511628211ull;
+		}
+
+		for(; i < size; i++)
+			h = (h ^ (unsigned char) data[i]) * 1099511628211ull;
+
+		return h;
+	};
+
+	const char * tables[2] = { (const char *) &mesh->gt(0), (const char *) &mesh->vt(0) };
+	const size_t sizes[2] = { sizeof(vertex) * mesh->n_vertices(), sizeof(index_t) * mesh->n_half_edges() };
+
+	uint64_t h = hash((const char *) sizes, sizeof(sizes), 14695981039346656037ull);
+
+	for(index_t t = 0; t < 2; t++)
 	{
-		D.insert(e, mesh->vt(mesh->et(e))) = 1;
-		D.insert(e, mesh->vt(next(mesh->et(e)))) = -1;
+		size_t block = ((sizes[t] + n_blocks - 1) / n_blocks + 7) / 8 * 8;
+		uint64_t hb[n_blocks];
+
+		#pragma omp parallel for
+		for(index_t b = 0; b < n_blocks; b++)
+		{
+			size_t begin = min(b * block, sizes[t]);
+			size_t end = min(begin + block, sizes[t]);
+			hb[b] = hash(tables[t] + begin, end - begin, 14695981039346656037ull);
+		}
 
-		S.insert(e, e) = (mesh->cotan(mesh->et(e)) +
-					mesh->cotan(mesh->ot_et(e))) / 2;
+		h = hash((const char *) hb, sizeof(hb), h);
 	}
 
-	L = D.transpose() * S * D;
+	return h;
+}
 
-	A.resize(n_vertices, n_vertices);
-	for(index_t v = 0; v < n_vertices; v++)
-		A.insert(v, v) = mesh->area_vertex(v);
+/// Header of the spectral cache files, the tables start at aligned offsets.
+struct spectral_header_t
+{
+	char magic[4];					///< "SPEC".
+	uint32_t version;
+	uint32_t real_size;				///< sizeof(real_t), depends on SINGLE_P.
+	uint32_t index_size;			///< sizeof(arma::uword).
+	uint32_t generalized;			///< 1 if the eigenpairs solve L x = lambda A x, 0 if L x = lambda x.
+	uint32_t reserved;
+	uint64_t hash;					///< hash_mesh.
+	uint64_t n_vertices;
+	uint64_t n_nonzero;
+	uint64_t K;
+	uint64_t offset[6];				///< col_ptrs, row_indices, values, areas, eigval, eigvec.
+};
+
+static const size_t SPECTRAL_ALIGN = 64;
+
+static void write_spectral(const string & file, const uint64_t & hash, const bool & generalized, const a_sp_mat & L, const a_sp_mat & A, const a_vec & eigval, const a_mat & eigvec)
+{
+	L.sync();
+
+	spectral_header_t h;
+	memset(&h, 0, sizeof(spectral_header_t));
+
+	memcpy(h.magic, "SPEC", 4);
+	h.version = 2;
+	h.real_size = sizeof(real_t);
+	h.index_size = sizeof(arma::uword);
+	h.generalized = generalized;
+	h.hash = hash;
+	h.n_vertices = L.n_rows;
+	h.n_nonzero = L.n_nonzero;
+	h.K = eigval.n_elem;
+
+	a_vec areas(A.diag());
+
+	const char * tables[6] = {	(char *) L.col_ptrs, (char *) L.row_indices, (char *) L.values,
+								(char *) areas.memptr(), (char *) eigval.memptr(), (char *) eigvec.memptr() };
+	const size_t sizes[6] = {	sizeof(arma::uword) * (h.n_vertices + 1),
+								sizeof(arma::uword) * h.n_nonzero,
+								sizeof(real_t) * h.n_nonzero,
+								sizeof(real_t) * h.n_vertices,
+								sizeof(real_t) * h.K,
+								sizeof(real_t) * h.n_vertices * h.K };
+
+	auto aligned = [](const size_t & offset) -> size_t
+	{
+		return (offset + SPECTRAL_ALIGN - 1) / SPECTRAL_ALIGN * SPECTRAL_ALIGN;
+	};
+
+	size_t offset = aligned(sizeof(spectral_header_t));
+	for(index_t i = 0; i < 6; i++)
+	{
+		h.offset[i] = offset;
+		offset = aligned(offset + sizes[i]);
+	}
+
+	// written in a temporary file and renamed, a reader never sees a partial file
+	const string tmp_file = file + '.' + to_string(getpid()) + ".tmp";
+	ofstream os(tmp_file, ios::binary);
+
+	char padding[SPECTRAL_ALIGN];
+	memset(padding, 0, sizeof(padding));
+
+	os.write((char *) &h, sizeof(spectral_header_t));
+	offset = sizeof(spectral_header_t);
+
+	for(index_t i = 0; i < 6; i++)
+	{
+		os.write(padding, h.offset[i] - offset);
+		os.write(tables[i], sizes[i]);
+		offset = h.offset[i] + sizes[i];
+	}
+
+	os.flush();
+	const bool ok = os.good();
+	os.close();
+
+	if(!ok || rename(tmp_file.c_str(), file.c_str()))
+		remove(tmp_file.c_str());
+}
+
+/// Loads the cache if it has the same key and at least K eigenpairs, returns the number of eigenpairs loaded.
+static size_t read_spectral(const string & file, const uint64_t & hash, const bool & generalized, a_sp_mat & L, a_sp_mat & A, a_vec & eigval, a_mat & eigvec, const size_t & K)
+{
+	if(access(file.c_str(), R_OK)) return 0;
+
+	mapped_file mf(file);
+	if(mf.size < sizeof(spectral_header_t)) return 0;
+
+	const spectral_header_t & h = *((const spectral_header_t *) mf.data);
+
+	if(strncmp(h.magic, "SPEC", 4) || h.version != 2) return 0;
+	if(h.real_size != sizeof(real_t) || h.index_size != sizeof(arma::uword)) return 0;
+	if(h.hash != hash || h.generalized != generalized || h.K < K) return 0;
+
+	// the tables in order, after the header and inside the file
+	if(h.n_vertices > mf.size || h.n_nonzero > mf.size || h.K > mf.size) return 0;
+	if(h.K && h.n_vertices > mf.size / h.K) return 0;
+
+	const size_t sizes[6] = {	sizeof(arma::uword) * (h.n_vertices + 1),
+								sizeof(arma::uword) * h.n_nonzero,
+								sizeof(real_t) * h.n_nonzero,
+								sizeof(real_t) * h.n_vertices,
+								sizeof(real_t) * h.K,
+								sizeof(real_t) * h.n_vertices * h.K };
+
+	size_t end = sizeof(spectral_header_t);
+	for(index_t i = 0; i < 6; i++)
+	{
+		if(h.offset[i] < end || h.offset[i] > mf.size || sizes[i] > mf.size - h.offset[i]) return 0;
+		end = h.offset[i] + sizes[i];
+	}
+
+	if(((const arma::uword *) (mf.data + h.offset[0]))[h.n_vertices] != h.n_nonzero) return 0;
+
+	auto table = [&](const index_t & i) -> const char *
+	{
+		return mf.data + h.offset[i];
+	};
+
+	L = a_sp_mat(	arma::uvec((const arma::uword *) table(1), h.n_nonzero),
+					arma::uvec((const arma::uword *) table(0), h.n_vertices + 1),
+					a_vec((const real_t *) table(2), h.n_nonzero),
+					h.n_vertices, h.n_vertices);
+
+	A.zeros(h.n_vertices, h.n_vertices);
+	A.diag() = a_vec((const real_t *) table(3), h.n_vertices);
+
+	// the first K eigenvectors are the first K columns
+	eigval = a_vec((const real_t *) table(4), K);
+	eigvec = a_mat((const real_t *) table(5), h.n_vertices, K);
+
+	return K;
+}
+
+/// Y = L X in parallel by columns of L, L is symmetric then its column i is its row i.
+static void mult_sym(a_mat & Y, const a_sp_mat & L, const a_mat & X)
+{
+	L.sync();
+	Y.set_size(X.n_rows, X.n_cols);
+
+	#pragma omp parallel for
+	for(index_t i = 0; i < L.n_cols; i++)
+	for(index_t j = 0; j < X.n_cols; j++)
+	{
+		real_t sum = 0;
+		for(arma::uword k = L.col_ptrs[i]; k < L.col_ptrs[i + 1]; k++)
+			sum += L.values[k] * X(L.row_indices[k], j);
+
+		Y(i, j) = sum;
+	}
+}
+
+/// MY = D L D Y, the operator of the standard problem equivalent to L x = lambda A x, with D = A^-1/2.
+static void mult_M(a_mat & MY, const a_sp_mat & L, const a_vec & D, const a_mat & Y)
+{
+	mult_sym(MY, L, Y.each_col() % D);
+	MY.each_col() %= D;
+}
+
+/// Rayleigh-Ritz of M in the orthonormal basis Y: Y and MY are rotated to the Ritz vectors.
+static void rayleigh_ritz(a_vec & lambda, a_mat & Y, a_mat & MY, const size_t & p)
+{
+	a_mat H = Y.t() * MY;
+	H = 0.5 * (H + H.t());
+
+	a_mat C;
+	eig_sym(lambda, C, H);
+
+	if(p < C.n_cols)
+	{
+		C = C.head_cols(p);
+		lambda = lambda.head(p);
+	}
+
+	Y = Y * C;
+	MY = MY * C;
+}
+
+/// True if the residuals of the first K Ritz pairs are small relative to the K-th eigenvalue.
+static bool converged(const a_vec & lambda, const a_mat & R, const size_t & K, const real_t & tol)
+{
+	real_t scale = max(abs(lambda(K - 1)), (real_t) 1);
+	for(index_t k = 0; k < K; k++)
+		if(norm(R.col(k)) > tol * scale) return false;
+
+	return true;
+}
+
+/*!
+	Subspace iteration with the cached cholmod factorization of L + sigma A: the K eigenvalues of
+	L x = lambda A x closest to -sigma are the largest of (L + sigma A)^-1 A, then each iteration
+	costs a solve with a block of p > K columns and a Rayleigh-Ritz with M = A^-1/2 L A^-1/2.
+*/
+static bool eigs_shift_invert(a_vec & eigval, a_mat & Y, const a_sp_mat & L, const a_vec & areas, const size_t & K, const real_t & tol, const size_t & max_iter)
+{
+	size_t n = L.n_rows;
+	size_t p = min(n, max(2 * K, K + 8));
+	if(K > n) return false;
+
+	a_vec S = sqrt(areas);
+	a_vec D = 1 / S;
+
+	// make L positive-definite, as the heat flow
+	a_sp_mat Ls = L;
+	Ls.diag() += 1.0e-8 * areas;
+
+	cholmod_common context;
+	cholmod_l_start(&context);
+
+	cholmod_sparse cL = cholmod_view(Ls);
+	cL.stype = 1;
+
+	cholmod_factor * F = cholmod_l_analyze(&cL, &context);
+	cholmod_l_factorize(&cL, F, &context);
+
+	a_mat Q, R, B, X(n, p), MY;
+	cholmod_dense cB, cX = cholmod_view(X);
+	cholmod_dense * pX = &cX, * W = NULL, * E = NULL;
+
+	arma::arma_rng::set_seed(0);
+	Y.randu(n, p);
+	qr_econ(Q, R, Y);
+	Y = Q;
+
+	bool done = false;
+	for(index_t it = 0; !done && it < max_iter; it++)
+	{
+		// Y = A^1/2 (L + sigma A)^-1 A^1/2 Y
+		B = Y.each_col() % S;
+		cB = cholmod_view(B);
+		cholmod_l_solve2(CHOLMOD_A, F, &cB, NULL, &pX, NULL, &W, &E, &context);
+		Y = X.each_col() % S;
+
+		qr_econ(Q, R, Y);
+		Y = Q;
+
+		mult_M(MY, L, D, Y);
+		rayleigh_ritz(eigval, Y, MY, p);
+
+		done = converged(eigval, MY - Y * diagmat(eigval), K, tol);
+	}
+
+	cholmod_l_free_factor(&F, &context);
+	cholmod_l_free_dense(&W, &context);
+	cholmod_l_free_dense(&E, &context);
+	cholmod_l_finish(&context);
+
+	Y.each_col() %= D;
+	return done;
+}
+
+/*!
+	LOBPCG with the Jacobi preconditioner for M = A^-1/2 L A^-1/2: each iteration does the
+	Rayleigh-Ritz in the span of the iterates X, the preconditioned residuals W and the previous
+	directions P. No factorization is needed, the products with L run in parallel.
+*/
+static bool eigs_lobpcg(a_vec & eigval, a_mat & Y, const a_sp_mat & L, const a_vec & areas, const size_t & K, const real_t & tol, const size_t & max_iter)
+{
+	size_t n = L.n_rows;
+	size_t p = max(K + K / 2, K + 8);
+	if(K > n) return false;
+
+	a_vec D = 1 / sqrt(areas);
+
+	// the basis [X W P] needs 3 p <= n, the small problems are solved dense
+	if(3 * p > n)
+	{
+		a_mat M = diagmat(D) * a_mat(L) * diagmat(D);
+		if(!eig_sym(eigval, Y, M)) return false;
+
+		Y.each_col() %= D;
+		return true;
+	}
+	a_vec T = 1 / (a_vec(L.diag()) % D % D);
+
+	a_mat Q, R, MY, MQ, P, S, Z;
+
+	arma::arma_rng::set_seed(0);
+	Y.randu(n, p);
+	qr_econ(Q, R, Y);
+	Y = Q;
+
+	mult_M(MY, L, D, Y);
+	rayleigh_ritz(eigval, Y, MY, p);
+
+	bool done = false;
+	for(index_t it = 0; it < max_iter; it++)
+	{
+		R = MY - Y * diagmat(eigval);
+		if((done = converged(eigval, R, K, tol))) break;
+
+		S = join_rows(Y, R.each_col() % T);
+		if(P.n_cols) S = join_rows(S, P);
+		qr_econ(Q, Z, S);
+
+		mult_M(MQ, L, D, Q);
+		rayleigh_ritz(eigval, Q, MQ, p);
+
+		// new directions: the part of the new iterates orthogonal to the old ones
+		P = Q - Y * (Y.t() * Q);
+
+		Y = Q;
+		MY = MQ;
+	}
+
+	Y.each_col() %= D;
+	return done;
 }
 
-size_t eigs_laplacian(a_vec & eigval, a_mat & eigvec, che * mesh, const a_sp_mat & L, const size_t & K)
+size_t eigs_laplacian(a_vec & eigval, a_mat & eigvec, a_sp_mat & L, a_sp_mat & A, che * mesh, const size_t & K, const eigs_option_t & opt)
 {
 	debug_me(LAPLACIAN)
 
-	string feigval = "tmp/" + mesh->name_size() + '_' + to_string(K) + ".L_eigval";
-	string feigvec = "tmp/" + mesh->name_size() + '_' + to_string(K) + ".L_eigvec";
+	uint64_t hash = hash_mesh(mesh);
+	bool generalized = opt != EIGS_SYM;
+
+	char key[17];
+	sprintf(key, "%016lx", (unsigned long) hash);
+
+	string file = "tmp/" + string(key) + ".spectral";
+	debug(file)
 
-	debug(feigval)
-	debug(feigvec)
+	if(read_spectral(file, hash, generalized, L, A, eigval, eigvec, K))
+		return eigval.n_elem;
 
-	if(!eigval.load(feigval) || !eigvec.load(feigvec))
+	laplacian(mesh, L, A);
+
+	if(!generalized)
 	{
 		if(!eigs_sym(eigval, eigvec, L, K, "sa"))
 			return 0;
+	}
+	else
+	{
+		a_vec areas(A.diag());
 
-		eigval.save(feigval);
-		eigvec.save(feigvec);
+		bool done = opt == SHIFT_INVERT ?	eigs_shift_invert(eigval, eigvec, L, areas, K, 1.0e-6, 200) :
+											eigs_lobpcg(eigval, eigvec, L, areas, K, 1.0e-6, 1000);
+		if(!done) return 0;
+
+		eigval = eigval.head(K);
+		eigvec = eigvec.head_cols(K);
 	}
 
+	write_spectral(file, hash, generalized, L, A, eigval, eigvec);
+
 	return eigval.n_elem;
 }
-
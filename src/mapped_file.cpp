@@ -0,0 +1,117 @@
+#include "mapped_file.h"
+
+#include <iostream>
+#include <cerrno>
+
+#include <omp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+mapped_file::mapped_file(const string & file)
+{
+	data = NULL;
+	size = 0;
+
+	int fd = open(file.c_str(), O_RDONLY);
+	if(fd == -1)
+	{
+		cerr << "Error: " << file << ": " << strerror(errno) << endl;
+		return;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) == -1)
+	{
+		cerr << "Error: " << file << ": " << strerror(errno) << endl;
+		close(fd);
+		return;
+	}
+
+	// mmap fails with a length of 0, an empty file is an empty mapping
+	if(!st.st_size)
+	{
+		close(fd);
+		return;
+	}
+
+	void * p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(p == MAP_FAILED)
+	{
+		cerr << "Error: " << file << ": " << strerror(errno) << endl;
+		return;
+	}
+
+	data = (const char *) p;
+	size = st.st_size;
+
+	madvise((void *) data, size, MADV_SEQUENTIAL);
+}
+
+mapped_file::~mapped_file()
+{
+	if(data) munmap((void *) data, size);
+}
+
+void mapped_file::split_lines(vector<size_t> & lines, const size_t & begin, const size_t & end, const char & comment) const
+{
+	// the chunks are shared by the threads of the team, which can be less than n_chunks
+	int n_chunks = omp_get_max_threads();
+
+	// offset of the beginning of the next line
+	auto next_line = [&](const size_t & i) -> size_t
+	{
+		const char * p = (const char *) memchr(data + i, '\n', end - i);
+		return p ? p - data + 1 : end;
+	};
+
+	auto is_line = [&](const size_t & i) -> bool
+	{
+		const char * p = skip_spaces(data + i, data + end);
+		return p < data + end && *p != '\n' && *p != comment;
+	};
+
+	// chunk t is [chunk[t], chunk[t + 1]), each chunk starts at the beginning of a line
+	vector<size_t> chunk(n_chunks + 1, end);
+	chunk[0] = begin;
+	for(int t = 1; t < n_chunks; t++)
+	{
+		size_t i = begin + (end - begin) * t / n_chunks;
+		chunk[t] = i > chunk[t - 1] && data[i - 1] != '\n' ? next_line(i) : max(i, chunk[t - 1]);
+	}
+
+	vector<size_t> n_lines(n_chunks + 1, 0);
+
+	#pragma omp parallel
+	{
+		#pragma omp for
+		for(int t = 0; t < n_chunks; t++)
+			for(size_t i = chunk[t]; i < chunk[t + 1]; i = next_line(i))
+				if(is_line(i)) n_lines[t + 1]++;
+
+		#pragma omp single
+		{
+			for(int k = 0; k < n_chunks; k++)
+				n_lines[k + 1] += n_lines[k];
+
+			lines.resize(n_lines[n_chunks]);
+		}
+
+		#pragma omp for
+		for(int t = 0; t < n_chunks; t++)
+		{
+			size_t l = n_lines[t];
+			for(size_t i = chunk[t]; i < chunk[t + 1]; i = next_line(i))
+				if(is_line(i)) lines[l++] = i;
+		}
+	}
+}
+
+void mapped_file::split_lines(vector<size_t> & lines, const size_t & begin, const char & comment) const
+{
+	split_lines(lines, begin, size, comment);
+}
+
@@ -5,6 +5,13 @@
 #include <iomanip>
 #include <vector>
 #include <fstream>
+#include <cstring>
+#include <cassert>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include <omp.h>
 
 // mesh dictionary learning and sparse coding namespace
 namespace mdict {
@@ -39,6 +46,118 @@ void OMP(a_vec & alpha, a_vec & x, a_mat & D, size_t L)
 	alpha.elem(selected_atoms) = aa;
 }
 
+omp_workspace::omp_workspace(const size_t & K, const size_t & m, const size_t & L):
+	Phi(K, K), phix(K), xx(0), a0(m), c(m), Pa(K), Aa(K), r(K), G(m, L), Lc(L, L), gamma(L), w(L), selected(L)
+{
+}
+
+void batch_OMP(real_t * alpha, const a_mat & A, const patch & p, const size_t & L, omp_workspace & ws)
+{
+	const size_t K = A.n_rows;
+	const size_t m = A.n_cols;
+	const size_t n = p.phi.n_rows;
+
+	memset(alpha, 0, sizeof(real_t) * m);
+
+	// the only products with the n rows of the patch
+	ws.Phi = p.phi.t() * p.phi;
+
+	real_t xx = 0;
+	ws.phix.zeros();
+	for(index_t i = 0; i < n; i++)
+	{
+		const real_t & x = p.xyz(2, i);
+		xx += x * x;
+		for(index_t k = 0; k < K; k++)
+			ws.phix(k) += p.phi(i, k) * x;
+	}
+
+	ws.a0 = A.t() * ws.phix;
+	ws.c = ws.a0;
+
+	double sigma = 0.001;
+	ws.xx = xx;
+	const real_t threshold = xx * sigma * sigma;		// squared residual norm
+
+	real_t error = xx, d;
+	index_t l = 0;
+	for(; error > threshold && l < L; l++)
+	{
+		arma::uword k = 0;
+		for(index_t j = 1; j < m; j++)
+			if(abs(ws.c(j)) > abs(ws.c(k))) k = j;
+
+		// gram column of the atom k
+		ws.Pa = ws.Phi * A.col(k);
+		a_vec g(ws.G.colptr(l), m, false, true);
+		g = A.t() * ws.Pa;
+
+		// Cholesky update: Lc(l, 0:l-1) = w, Lc w = G(selected, l)
+		d = g(k);
+		for(index_t i = 0; i < l; i++)
+		{
+			ws.w(i) = ws.G(ws.selected(i), l);
+			for(index_t j = 0; j < i; j++)
+				ws.w(i) -= ws.Lc(i, j) * ws.w(j);
+			ws.w(i) /= ws.Lc(i, i);
+			d -= ws.w(i) * ws.w(i);
+		}
+
+		// atom dependent of the selected atoms, the residual can not be reduced: OMP selects the
+		// same atom again with the same residual until L, the codes only differ in the split of
+		// the coefficient between the copies of the atom
+		if(d <= 1e-12 * g(k)) break;
+
+		for(index_t j = 0; j < l; j++)
+			ws.Lc(l, j) = ws.w(j);
+		ws.Lc(l, l) = sqrt(d);
+		ws.selected(l) = k;
+
+		// Lc Lc^T gamma = a0(selected)
+		for(index_t i = 0; i <= l; i++)
+		{
+			ws.gamma(i) = ws.a0(ws.selected(i));
+			for(index_t j = 0; j < i; j++)
+				ws.gamma(i) -= ws.Lc(i, j) * ws.gamma(j);
+			ws.gamma(i) /= ws.Lc(i, i);
+		}
+		for(index_t i = l + 1; i-- > 0;)
+		{
+			for(index_t j = i + 1; j <= l; j++)
+				ws.gamma(i) -= ws.Lc(j, i) * ws.gamma(j);
+			ws.gamma(i) /= ws.Lc(i, i);
+		}
+
+		// c = a0 - G gamma, |r|^2 = |x|^2 - a0(selected)^T gamma
+		for(index_t j = 0; j < m; j++)
+		{
+			ws.c(j) = ws.a0(j);
+			for(index_t i = 0; i <= l; i++)
+				ws.c(j) -= ws.G(j, i) * ws.gamma(i);
+		}
+
+		error = xx;
+		for(index_t i = 0; i <= l; i++)
+			error -= ws.a0(ws.selected(i)) * ws.gamma(i);
+	}
+
+	for(index_t i = 0; i < l; i++)
+		alpha[ws.selected(i)] = ws.gamma(i);
+}
+
+void OMP_all_patches_batch(a_mat & alpha, const a_mat & A, const vector<patch> & patches, const size_t & M, const size_t & L)
+{
+	#pragma omp parallel
+	{
+		omp_workspace ws(A.n_rows, A.n_cols, L);
+
+		#pragma omp for schedule(dynamic)
+		for(index_t i = 0; i < M; i++)
+			if(patches[i].valid_xyz())
+				batch_OMP(alpha.colptr(i), A, patches[i], L, ws);
+	}
+}
+
 void KSVD(a_mat & D, a_mat & X, size_t L)
 {
 	size_t n = X.n_rows;
@@ -99,43 +218,174 @@ void OMP_all_patches_ksvt(a_mat & alpha, a_mat & A, vector<patch> & patches, siz
 		OMP_patch(alpha, A, i, patches[i], L);
 }
 
-void KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L)
+/// Codes the patches order[0, n) with batch_OMP into the columns of alpha, and keeps for each one
+/// the gram matrix phi^T phi, the columns [K i, K i + K) of Phi, and phi^T times the residual of
+/// the patch, the column i of Pr. Returns the squared residual of the patches, error(i) of each one.
+static real_t code_patches(a_mat & alpha, a_mat & Phi, a_mat & Pr, a_vec & error, const a_mat & A, const vector<patch> & patches, const index_t * order, const size_t & n, const size_t & L)
+{
+	const size_t K = A.n_rows;
+	const size_t m = A.n_cols;
+
+	#pragma omp parallel
+	{
+		omp_workspace ws(K, m, L);
+
+		#pragma omp for schedule(dynamic)
+		for(index_t i = 0; i < n; i++)
+		{
+			real_t * a = alpha.colptr(i);
+			batch_OMP(a, A, patches[order[i]], L, ws);
+
+			ws.Aa.zeros();
+			for(index_t j = 0; j < m; j++)
+				if(a[j]) ws.Aa += a[j] * A.col(j);
+
+			// r = phi^T (x - phi A alpha), |x - phi A alpha|^2 = x^T x - Aa^T phix - Aa^T r
+			ws.r = ws.phix - ws.Phi * ws.Aa;
+
+			Phi.cols(K * i, K * i + K - 1) = ws.Phi;
+			Pr.col(i) = ws.r;
+
+			error(i) = ws.xx - dot(ws.Aa, ws.phix) - dot(ws.Aa, ws.r);
+		}
+	}
+
+	return accu(error.head(n));
+}
+
+/// Adds the normal equations of the n patches coded by code_patches to the atoms, S_j (K x K) are
+/// the columns [K j, K j + K) of S. Each atom is accumulated by one thread over the patches in order,
+/// then the result does not depend on the number of threads.
+/// atom j: min |x - phi A alpha + alpha_j phi a_j - alpha_j phi a|^2
+static void accumulate_atoms(a_mat & S, a_mat & R, arma::uvec & used, const a_mat & A, const a_mat & alpha, const a_mat & Phi, const a_mat & Pr, const size_t & n)
+{
+	const size_t K = A.n_rows;
+	const size_t m = A.n_cols;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(index_t j = 0; j < m; j++)
+	for(index_t i = 0; i < n; i++)
+	{
+		const real_t & a = alpha(j, i);
+		if(!a) continue;
+
+		S.cols(K * j, K * j + K - 1) += a * a * Phi.cols(K * i, K * i + K - 1);
+		R.col(j) += a * (Pr.col(i) + a * Phi.cols(K * i, K * i + K - 1) * A.col(j));
+		used(j)++;
+	}
+}
+
+/// Solves all the atoms from their normal equations.
+static void update_atoms(a_mat & A, const a_mat & S, const a_mat & R, const arma::uvec & used)
+{
+	const size_t K = A.n_rows;
+	const size_t m = A.n_cols;
+
+	#pragma omp parallel for
+	for(index_t j = 0; j < m; j++)
+	{
+		a_vec X;
+		if(used(j) && solve(X, S.cols(K * j, K * j + K - 1), R.col(j)))
+			A.col(j) = X;
+	}
+}
+
+void KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L, const real_t & tol, size_t max_iter)
 {
 	size_t K = A.n_rows;
 	size_t m = A.n_cols;
 
-	a_mat alpha(m, M);
+	if(!max_iter) max_iter = L;
 
-	size_t iter = L;
-	while(iter--)
+	// the patches are coded in chunks, only the codes and grams of a chunk are stored
+	const size_t chunk = min(M, (size_t) 64 * omp_get_max_threads());
+
+	a_mat alpha(m, chunk), Phi(K, K * chunk), Pr(K, chunk);
+	a_vec E(chunk);
+	a_mat S(K, K * m), R(K, m);
+	arma::uvec used(m);
+
+	vector<index_t> order(M);
+	iota(order.begin(), order.end(), 0);
+
+	real_t error, old_error = INFINITY;
+
+	for(index_t it = 0; it < max_iter; it++)
 	{
-		OMP_all_patches_ksvt(alpha, A, patches, M, L);
+		error = 0;
 
-		#pragma omp parallel for
-		for(index_t j = 0; j < m; j++)
+		S.zeros();
+		R.zeros();
+		used.zeros();
+
+		for(index_t b = 0; b < M; b += chunk)
 		{
-			arma::uvec omega = find(abs(alpha.row(j)) > 0);
+			const size_t n = min(chunk, M - b);
 
-			a_mat sum(K, K, arma::fill::zeros);
-			a_vec sum_error(K, arma::fill::zeros);
+			error += code_patches(alpha, Phi, Pr, E, A, patches, order.data() + b, n, L);
+			accumulate_atoms(S, R, used, A, alpha, Phi, Pr, n);
+		}
 
-			for(arma::uword o: omega)
-			{
-				sum += alpha(j, o) * patches[o].phi.t() * patches[o].phi;
+		debug(error)
+		if(old_error - error < tol * old_error) break;
+		old_error = error;
 
-				a_mat D = patches[o].phi * A;
-				D.col(j).zeros();
-				a_mat e = patches[o].xyz.row(2).t() - D * alpha.col(o);
+		update_atoms(A, S, R, used);
+	}
+}
 
-				sum_error += alpha(j, o) * patches[o].phi.t() * e;
-			}
-			if(omega.size())
+void online_KSVDT(a_mat & A, vector<patch> & patches, size_t M, size_t L, const size_t & batch_size, const double & max_time, const real_t & tol, const size_t & max_epochs)
+{
+	size_t K = A.n_rows;
+	size_t m = A.n_cols;
+
+	assert(batch_size > 0);
+
+	double start = omp_get_wtime();
+
+	// sufficient statistics of all the seen patches
+	a_mat S(K, K * m, arma::fill::zeros), R(K, m, arma::fill::zeros);
+	arma::uvec used(m, arma::fill::zeros);
+
+	// each epoch visits the patches in a random order
+	vector<index_t> order(M);
+	iota(order.begin(), order.end(), 0);
+	mt19937 gen(0);
+
+	a_mat alpha(m, batch_size), Phi(K, K * batch_size), Pr(K, batch_size);
+	a_vec E(batch_size);
+	real_t error = 0, old_error = INFINITY;
+
+	index_t t = 1;
+	for(index_t epoch = 0; epoch < max_epochs; epoch++)
+	{
+		shuffle(order.begin(), order.end(), gen);
+
+		for(index_t b = 0; b < M; b += batch_size, t++)
+		{
+			const size_t n = min(batch_size, M - b);
+
+			error += code_patches(alpha, Phi, Pr, E, A, patches, order.data() + b, n, L);
+
+			// the statistics of the first batches, coded with a worse A, are forgotten: (1 - 1/t)^2
+			const real_t beta = (1 - 1.0 / t) * (1 - 1.0 / t);
+			S *= beta;
+			R *= beta;
+
+			accumulate_atoms(S, R, used, A, alpha, Phi, Pr, n);
+			update_atoms(A, S, R, used);
+
+			if(omp_get_wtime() - start > max_time)
 			{
-				a_vec X;
-				solve(X, sum, sum_error);
-				A.col(j) = X;
+				debug(epoch)
+				return;
 			}
 		}
+
+		debug(error)
+		if(old_error - error < tol * old_error) break;
+		old_error = error;
+		error = 0;
 	}
 }
 
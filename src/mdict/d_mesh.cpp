@@ -235,9 +235,11 @@ void partial_mesh_reconstruction(size_t old_n_vertices, che * mesh, size_t M, ve
 		mesh->get_vertex(v) = *((vertex *) V.memptr());
 	}
 
+	mesh->update_geometry();
+
 }
 
-void mesh_reconstruction(che * mesh, size_t M, vector<patch> & patches, vector<vpatches_t> & patches_map, a_mat & A, a_mat & alpha, const index_t & v_i)
+void mesh_reconstruction(che * mesh, size_t M, vector<patch> & patches, const patches_store & patches_map, a_mat & A, a_mat & alpha, const index_t & v_i)
 {
 	a_mat V(3, mesh->n_vertices(), arma::fill::zeros);
 
@@ -276,7 +278,7 @@ void mesh_reconstruction(che * mesh, size_t M, vector<patch> & patches, vector<v
 	distance_t error = 0;
 	#pragma omp parallel for reduction(+: error)
 	for(index_t v = v_i; v < mesh->n_vertices(); v++)
-		error += *(new_vertices[v] - mesh->get_vertex(v));
+		error += *(new_vertices[v] - mesh->gt(v));
 
 	debug(mesh->n_vertices())
 	error /= mesh->n_vertices();
@@ -286,7 +288,7 @@ void mesh_reconstruction(che * mesh, size_t M, vector<patch> & patches, vector<v
 	mesh->set_vertices(new_vertices + v_i, mesh->n_vertices() - v_i, v_i);
 }
 
-a_vec non_local_means_vertex(a_mat & alpha, const index_t & v, vector<patch> & patches, vector<vpatches_t> & patches_map, const distance_t & h)
+a_vec non_local_means_vertex(a_mat & alpha, const index_t & v, vector<patch> & patches, const patches_store & patches_map, const distance_t & h)
 {
 	a_vec n_a_vec(3, arma::fill::zeros);
 	area_t sum = 0;
@@ -361,7 +363,7 @@ void mesh_reconstruction(che * mesh, size_t M, vector<patch_t> & patches, vector
 	distance_t error = 0;
 	#pragma omp parallel for reduction(+: error)
 	for(index_t v = v_i; v < mesh->n_vertices(); v++)
-		error += *(new_vertices[v] - mesh->get_vertex(v));
+		error += *(new_vertices[v] - mesh->gt(v));
 
 	debug(mesh->n_vertices())
 	error /= mesh->n_vertices();
@@ -6,12 +6,16 @@
 #include "che_fill_hole.h"
 
 #include <cassert>
+#include <cstring>
 
 // mesh dictionary learning and sparse coding namespace
 namespace mdict {
 
 size_t dictionary::L = 10;
 size_t dictionary::T = 5;
+bool dictionary::batch_omp = false;
+size_t dictionary::online_batch = 0;
+double dictionary::online_time = 60;
 
 dictionary::dictionary(che *const & _mesh, basis *const & _phi_basis, const size_t & _m, const size_t & _M, const distance_t & _f, const bool & _d_plot):
 					mesh(_mesh), phi_basis(_phi_basis), m(_m), M(_M), f(_f), d_plot(_d_plot)
@@ -28,7 +32,10 @@ void dictionary::learning()
 {
 	debug_me(MDICT)
 
-	string f_dict = "tmp/" + mesh->name_size() + '_' + to_string(phi_basis->dim) + '_' + to_string(m) + ".dict";
+	// the online dictionaries (time budget) are not cached as KSVDT dictionaries
+	string f_dict = "tmp/" + mesh->name_size() + '_' + to_string(phi_basis->dim) + '_' + to_string(m);
+	if(online_batch) f_dict += "_online" + to_string(online_batch);
+	f_dict += ".dict";
 	debug(f_dict)
 
 	if(!A.load(f_dict))
@@ -36,7 +43,9 @@ void dictionary::learning()
 		A.eye(phi_basis->dim, m);
 		// A.random(phi_basis->dim, m);
 
-		KSVDT(A, patches, M, L);
+		if(online_batch) online_KSVDT(A, patches, M, L, online_batch, online_time);
+		else KSVDT(A, patches, M, L);
+
 		A.save(f_dict);
 	}
 
@@ -55,7 +64,9 @@ void dictionary::sparse_coding()
 	debug_me(MDICT)
 
 	alpha.zeros(m, M);
-	OMP_all_patches_ksvt(alpha, A, patches, M, L);
+
+	if(batch_omp) OMP_all_patches_batch(alpha, A, patches, M, L);
+	else OMP_all_patches_ksvt(alpha, A, patches, M, L);
 }
 
 void dictionary::init_sampling()
@@ -87,22 +98,25 @@ void dictionary::init_patches(const bool & reset, const fmask_t & mask)
 	if(reset)
 	{
 		patches.resize(M);
-		patches_map.resize(n_vertices);
 
 		#pragma omp parallel
 		{
+			// one reset per thread, the patches reset only the entries they touch
 			index_t * toplevel = new index_t[n_vertices];
+			memset(toplevel, -1, sizeof(index_t) * n_vertices);
 
-			#pragma omp for 
+			#pragma omp for schedule(dynamic)
 			for(index_t s = 0; s < M; s++)
 			{
 				index_t v = sample(s);
-				patches[s].init(mesh, v, dictionary::T, phi_basis->radio);
+				patches[s].init(mesh, v, dictionary::T, phi_basis->radio, toplevel);
 			}
 
 			delete [] toplevel;
 		}
 
+		patches_map.pack(patches, n_vertices);
+
 		#ifndef NDEBUG
 			size_t patch_avg_size = 0;
 			size_t patch_min_size = NIL;
@@ -110,13 +124,13 @@ void dictionary::init_patches(const bool & reset, const fmask_t & mask)
 
 			#pragma omp parallel for reduction(+: patch_avg_size)
 			for(index_t s = 0; s < M; s++)
-				patch_avg_size += patches[s].vertices.size();
+				patch_avg_size += patches_map.size(s);
 			#pragma omp parallel for reduction(min: patch_min_size)
 			for(index_t s = 0; s < M; s++)
-				patch_min_size = min(patches[s].vertices.size(), patch_min_size);
+				patch_min_size = min(patches_map.size(s), patch_min_size);
 			#pragma omp parallel for reduction(max: patch_max_size)
 			for(index_t s = 0; s < M; s++)
-				patch_max_size = max(patches[s].vertices.size(), patch_max_size);
+				patch_max_size = max(patches_map.size(s), patch_max_size);
 
 			patch_avg_size /= M;
 			debug(patch_avg_size)
@@ -125,8 +139,7 @@ void dictionary::init_patches(const bool & reset, const fmask_t & mask)
 		#endif
 	}
 
-	for(index_t s = 0; s < M; s++)
-		patches[s].reset_xyz(mesh, patches_map, s, mask);
+	patches_map.reset_xyz(mesh, patches, phi_basis->dim, mask);
 
 	#pragma omp parallel for
 	for(index_t s = 0; s < M; s++)
@@ -134,7 +147,6 @@ void dictionary::init_patches(const bool & reset, const fmask_t & mask)
 		patch & p = patches[s];
 
 		p.transform();
-		p.phi.set_size(p.xyz.n_cols, phi_basis->dim);
 		phi_basis->discrete(p.phi, p.xyz);
 	}
 }
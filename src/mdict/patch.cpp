@@ -2,6 +2,10 @@
 
 #include "dictionary.h"
 
+#include <new>
+#include <cstring>
+#include <algorithm>
+
 #ifndef CGAL_PATCH_DEFS
 	#define CGAL_PATCH_DEFS
 	#define CGAL_EIGEN3_ENABLED
@@ -24,11 +28,17 @@ typedef My_Monge_via_jet_fitting::Monge_form My_Monge_form;
 namespace mdict {
 
 size_t patch::expected_nv = 3 * dictionary::T * (dictionary::T + 1);
+size_t patch::min_nvp = 36;
 
 void patch::init(che * mesh, const index_t & v, const size_t & n_toplevels, const distance_t & radio, index_t * _toplevel)
 {
-	index_t * toplevel = _toplevel ? _toplevel : new index_t[mesh->n_vertices()];
-	
+	index_t * toplevel = _toplevel;
+	if(!toplevel)
+	{
+		toplevel = new index_t[mesh->n_vertices()];
+		memset(toplevel, -1, sizeof(index_t) * mesh->n_vertices());
+	}
+
 	gather_vertices(mesh, v, n_toplevels, toplevel);
 	jet_fit_directions(mesh, v);
 	gather_vertices(mesh, v, radio, toplevel);
@@ -49,29 +59,25 @@ void patch::itransform()
 	xyz.each_col() += x;
 }
 
-void patch::reset_xyz(che * mesh, vector<vpatches_t> & vpatches, const index_t & p, const fmask_t & mask)
+/// Makes X a matrix over mem (no copy). Armadillo can not point a matrix to other memory and
+/// assigning a_mat(mem, ...) copies the values, then X is destroyed and built again in place:
+/// the destructor frees only the memory X owns (never mem), and X is a live object again before
+/// any other use, no reference to the elements of the old X is kept by the patches.
+static void alias(a_mat & X, real_t * mem, const size_t & n_rows, const size_t & n_cols)
 {
-	size_t m = vertices.size();
-	if(mask)
-	{
-		m = 0;
-		for(index_t i = 0; i < vertices.size(); i++)
-			if(mask(vertices[i])) m++;
-	}
+	X.~a_mat();
+	new (&X) a_mat(mem, n_rows, n_cols, false, true);
+}
 
-	xyz.set_size(3, m);
-	for(index_t j = 0, i = 0; i < vertices.size(); i++)
-	{
-		if(!mask || mask(vertices[i]))
-		{
-			const vertex & v = mesh->gt(vertices[i]);
-			xyz(0, j) = v.x;
-			xyz(1, j) = v.y;
-			xyz(2, j) = v.z;
+bool patch::valid_xyz() const
+{
+	return xyz.n_cols > min_nvp;
+}
 
-			vpatches[vertices[i]].push_back({p, j++});
-		}
-	}
+void patch::bind(real_t * xyz_mem, real_t * phi_mem, const size_t & n, const size_t & dim)
+{
+	alias(xyz, xyz_mem, 3, n);
+	alias(phi, phi_mem, n, dim);
 }
 
 void patch::gather_vertices(che * mesh, const index_t & v, const size_t & n_toplevels, index_t * toplevel)
@@ -79,7 +85,6 @@ void patch::gather_vertices(che * mesh, const index_t & v, const size_t & n_topl
 	if(vertices.size()) vertices.clear();
 
 	vertices.reserve(expected_nv);
-	memset(toplevel, -1, sizeof(index_t) * mesh->n_vertices());
 	
 	link_t link;
 	toplevel[v] = 0;
@@ -102,7 +107,11 @@ void patch::gather_vertices(che * mesh, const index_t & v, const size_t & n_topl
 		}
 
 		link.clear();	
-	}	
+	}
+
+	// sparse reset, the touched vertices are the gathered vertices
+	for(const index_t & u: vertices)
+		toplevel[u] = NIL;
 }
 
 void patch::gather_vertices(che * mesh, const index_t & v, const distance_t & radio, index_t * toplevel)
@@ -114,7 +123,6 @@ void patch::gather_vertices(che * mesh, const index_t & v, const distance_t & ra
 	qvertices.reserve(expected_nv);
 	
 	vertices.reserve(expected_nv);
-	memset(toplevel, -1, sizeof(index_t) * mesh->n_vertices());
 	
 	size_t count_toplevel = 0;
 	size_t current_toplevel = 0;
@@ -157,7 +165,11 @@ void patch::gather_vertices(che * mesh, const index_t & v, const distance_t & ra
 		}
 
 		link.clear();	
-	}	
+	}
+
+	// sparse reset, the touched vertices are the queued vertices
+	for(const index_t & u: qvertices)
+		toplevel[u] = NIL;
 }
 
 /// Compute the principal directions of the patch, centering in the vertex \f$v\f$.
@@ -198,5 +210,151 @@ void patch::jet_fit_directions(che * mesh, const index_t & v)
 	T(2, 2) = monge_form.normal_direction()[2];
 }
 
+patches_store::~patches_store()
+{
+	delete [] offsets;
+	delete [] vertices;
+	free_xyz();
+}
+
+void patches_store::pack(vector<patch> & patches, const size_t & _n_vertices)
+{
+	M = patches.size();
+	n_vertices = _n_vertices;
+
+	delete [] offsets;
+	delete [] vertices;
+
+	offsets = new index_t[M + 1];
+
+	offsets[0] = 0;
+	for(index_t s = 0; s < M; s++)
+		offsets[s + 1] = offsets[s] + patches[s].vertices.size();
+
+	vertices = new index_t[offsets[M]];
+
+	#pragma omp parallel for
+	for(index_t s = 0; s < M; s++)
+	{
+		memcpy(vertices + offsets[s], patches[s].vertices.data(), sizeof(index_t) * patches[s].vertices.size());
+		vector<index_t>().swap(patches[s].vertices);
+	}
+}
+
+void patches_store::reset_xyz(che * mesh, vector<patch> & patches, const size_t & dim, const fmask_t & mask)
+{
+	assert(patches.size() == M);
+
+	free_xyz();
+
+	// columns of each patch
+	xyz_offsets = new index_t[M + 1];
+	xyz_offsets[0] = 0;
+
+	#pragma omp parallel for
+	for(index_t s = 0; s < M; s++)
+	{
+		size_t m = offsets[s + 1] - offsets[s];
+		if(mask)
+		{
+			m = 0;
+			for(index_t i = offsets[s]; i < offsets[s + 1]; i++)
+				if(mask(vertices[i])) m++;
+		}
+
+		xyz_offsets[s + 1] = m;
+	}
+
+	for(index_t s = 0; s < M; s++)
+		xyz_offsets[s + 1] += xyz_offsets[s];
+
+	xyz = new real_t[3 * xyz_offsets[M]];
+	phi = new real_t[dim * xyz_offsets[M]];
+
+	map_offsets = new index_t[n_vertices + 1];
+	memset(map_offsets, 0, sizeof(index_t) * (n_vertices + 1));
+
+	// coordinates and counting pass of the inverse index
+	#pragma omp parallel for
+	for(index_t s = 0; s < M; s++)
+	{
+		patch & p = patches[s];
+		p.bind(xyz + 3 * xyz_offsets[s], phi + dim * xyz_offsets[s], xyz_offsets[s + 1] - xyz_offsets[s], dim);
+
+		for(index_t j = 0, i = offsets[s]; i < offsets[s + 1]; i++)
+		{
+			const index_t & u = vertices[i];
+			if(!mask || mask(u))
+			{
+				const vertex & v = mesh->gt(u);
+				p.xyz(0, j) = v.x;
+				p.xyz(1, j) = v.y;
+				p.xyz(2, j) = v.z;
+
+				#pragma omp atomic
+				map_offsets[u + 1]++;
+
+				j++;
+			}
+		}
+	}
+
+	for(index_t v = 0; v < n_vertices; v++)
+		map_offsets[v + 1] += map_offsets[v];
+
+	map = new vpatch_t[map_offsets[n_vertices]];
+
+	index_t * cursor = new index_t[n_vertices];
+	memcpy(cursor, map_offsets, sizeof(index_t) * n_vertices);
+
+	#pragma omp parallel for
+	for(index_t s = 0; s < M; s++)
+		for(index_t j = 0, i = offsets[s]; i < offsets[s + 1]; i++)
+		{
+			const index_t & u = vertices[i];
+			if(!mask || mask(u))
+			{
+				index_t pos;
+
+				#pragma omp atomic capture
+				pos = cursor[u]++;
+
+				map[pos] = {s, j++};
+			}
+		}
+
+	delete [] cursor;
+
+	// the pairs of a vertex sorted by patch, the order of a serial construction
+	#pragma omp parallel for
+	for(index_t v = 0; v < n_vertices; v++)
+		sort(map + map_offsets[v], map + map_offsets[v + 1]);
+}
+
+size_t patches_store::size(const index_t & s) const
+{
+	return offsets[s + 1] - offsets[s];
+}
+
+vpatches_t patches_store::operator[](const index_t & v) const
+{
+	return {map + map_offsets[v], map + map_offsets[v + 1]};
+}
+
+void patches_store::free_xyz()
+{
+	delete [] xyz_offsets;
+	delete [] xyz;
+	delete [] phi;
+	delete [] map_offsets;
+	delete [] map;
+
+	xyz_offsets = NULL;
+	xyz = NULL;
+	phi = NULL;
+	map_offsets = NULL;
+	map = NULL;
+}
+
 } // mdict
 
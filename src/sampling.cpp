@@ -1,8 +1,10 @@
 #include "sampling.h"
 #include "geodesics_ptp.h"
+#include "geodesics_query.h"
 #include "che_off.h"
 
 #include <fstream>
+#include <cstring>
 
 index_t ** sampling_shape(vector<index_t> & points, size_t *& sizes, vertex *& normals, che * shape, size_t n_points, distance_t radio)
 {
@@ -10,20 +12,19 @@ index_t ** sampling_shape(vector<index_t> & points, size_t *& sizes, vertex *& n
 	sizes = new size_t[n_points];
 	index_t ** indexes = new index_t * [n_points];
 
-	index_t v;
+	geodesics_query gq(shape);
 
-	#pragma omp parallel for private(v)
+	#pragma omp parallel for schedule(dynamic)
 	for(index_t i = 0; i < n_points; i++)
 	{
-		v = points[i];
+		const index_t & v = points[i];
 		normals[i] = shape->normal(v);
 
-		geodesics fm(shape, {v}, geodesics::FM, NIL, radio);
+		const geodesics_query::scratch_t & fm = gq.query({v}, radio);
 
-		indexes[i] = new index_t[fm.n_sorted_index()];
-
-		fm.copy_sorted_index(indexes[i], fm.n_sorted_index());
-		sizes[i] = fm.n_sorted_index();
+		sizes[i] = fm.sorted.size();
+		indexes[i] = new index_t[sizes[i]];
+		memcpy(indexes[i], fm.sorted.data(), sizes[i] * sizeof(index_t));
 	}
 
 	return indexes;
@@ -58,7 +59,7 @@ bool load_sampling(vector<index_t> & points, distance_t & radio, che * mesh, siz
 			points.push_back(0);
 
 		double time_fps;
-		radio = farthest_point_sampling_ptp_gpu(mesh, points, time_fps, n);
+		radio = farthest_point_sampling_ptp(mesh, points, time_fps, n);
 		debug(time_fps)
 
 		ofstream os(file);
@@ -285,7 +285,11 @@ double test_heat_method_cholmod(distance_t & error, double & stime, const distan
 	{
 		if(dist) delete [] dist;
 		
-		TIC(t) dist = heat_flow(mesh, source, st); TOC(t)
+		// a new solver each time: the time includes the factorizations, not cached by the mesh
+		TIC(t)
+		heat_flow_solver solver(mesh);
+		dist = solver(source, st);
+		TOC(t)
 		ptime = min(t - st, ptime);
 		stime = min(st, stime);
 	}
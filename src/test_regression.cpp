@@ -0,0 +1,222 @@
+#include "test_regression.h"
+
+#include "che_io.h"
+#include "che_off.h"
+#include "geodesics_ptp.h"
+#include "laplacian.h"
+#include "mdict/d_dict_learning.h"
+
+#include <cstdio>
+#include <omp.h>
+
+int main_test_regression(const int & nargs, const char ** args)
+{
+	if(nargs < 2)
+	{
+		printf("./test_regression [mesh path] ...\n");
+		return 0;
+	}
+
+	int n_failed = 0;
+	auto run = [&](const char * name, const bool & passed)
+	{
+		printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+		n_failed += !passed;
+	};
+
+	run("laplacian_non_manifold", test_laplacian_non_manifold());
+	run("batch_omp", test_batch_omp());
+	run("ksvdt", test_ksvdt());
+
+	for(int i = 1; i < nargs; i++)
+	{
+		che * mesh = load_mesh(args[i]);
+		printf("%s: %lu vertices\n", args[i], mesh->n_vertices());
+
+		if(!mesh->n_vertices())
+		{
+			run("load_mesh", false);
+			delete mesh;
+			continue;
+		}
+
+		run("ptp_active", test_ptp_active(mesh));
+		run("laplacian", test_laplacian(mesh));
+
+		delete mesh;
+	}
+
+	return n_failed;
+}
+
+bool test_ptp_active(che * mesh)
+{
+	const size_t & n_vertices = mesh->n_vertices();
+
+	index_t * toplesets = new index_t[n_vertices];
+	index_t * sorted_index = new index_t[n_vertices];
+
+	bool passed = true;
+	for(const vector<index_t> & sources: {vector<index_t>{0}, vector<index_t>{0, index_t(n_vertices / 2), index_t(n_vertices - 1)}})
+	{
+		vector<index_t> limits;
+		mesh->compute_toplesets(toplesets, sorted_index, limits, sources);
+
+		distance_t * ptp = parallel_toplesets_propagation_cpu(mesh, sources, limits, sorted_index);
+		distance_t * active = parallel_toplesets_propagation_active_cpu(mesh, sources, limits, sorted_index, 0);
+
+		for(index_t v = 0; v < n_vertices; v++)
+			passed = passed && ptp[v] == active[v];
+
+		delete [] ptp;
+		delete [] active;
+	}
+
+	delete [] toplesets;
+	delete [] sorted_index;
+
+	return passed;
+}
+
+bool test_laplacian(che * mesh)
+{
+	const size_t & n_vertices = mesh->n_vertices();
+	const size_t & n_edges = mesh->n_edges();
+
+	size_t n_nonzero = laplacian_nnz(mesh);
+
+	long * col_ptrs = new long[n_vertices + 1];
+	long * row_indices = new long[n_nonzero];
+	double * values = new double[n_nonzero];
+	double * areas = new double[n_vertices];
+
+	size_t nnz = laplacian(mesh, col_ptrs, row_indices, values, areas);
+
+	bool passed = nnz == (size_t) col_ptrs[n_vertices] && nnz <= n_nonzero;
+	for(index_t v = 0; v < n_vertices; v++)
+	for(long k = col_ptrs[v] + 1; k < col_ptrs[v + 1]; k++)
+		passed = passed && row_indices[k - 1] < row_indices[k];
+
+	delete [] col_ptrs;
+	delete [] row_indices;
+	delete [] values;
+	delete [] areas;
+
+	// reference: L = D^T S D, D (edges x vertices) the differences and S the cotan weights
+	arma::umat DI(2, 2 * n_edges);
+	a_vec DV(2 * n_edges);
+
+	arma::umat SI(2, n_edges);
+	a_vec SV(n_edges);
+
+	for(index_t e = 0; e < n_edges; e++)
+	{
+		DI(0, 2 * e) = DI(0, 2 * e + 1) = e;
+		DI(1, 2 * e) = mesh->vt(mesh->et(e));
+		DI(1, 2 * e + 1) = mesh->vt(next(mesh->et(e)));
+		DV(2 * e) = -1;
+		DV(2 * e + 1) = 1;
+
+		SI(0, e) = SI(1, e) = e;
+		SV(e) = (mesh->cotan(mesh->et(e)) + mesh->cotan(mesh->ot_et(e))) / 2;
+	}
+
+	a_sp_mat D(true, DI, DV, n_edges, n_vertices);
+	a_sp_mat S(SI, SV, n_edges, n_edges);
+
+	a_sp_mat L, A;
+	laplacian(mesh, L, A);
+
+	a_sp_mat R = D.t() * S * D;
+
+	return passed && norm(L - L.t(), "fro") == 0 && norm(L - R, "fro") <= 1e-10 * norm(R, "fro");
+}
+
+bool test_laplacian_non_manifold()
+{
+	// the edge (0, 1) is shared by three triangles, the vertex 2 joins two fans
+	vector<vertex> vertices = {	vertex(0, 0, 0), vertex(1, 0, 0), vertex(0.5, 1, 0), vertex(0.5, -1, 0),
+								vertex(0.5, 0, 1), vertex(1.5, 1.5, 0.2), vertex(-0.5, 1.5, 0.1) };
+	vector<index_t> faces = {0, 1, 2, 1, 0, 3, 0, 1, 4, 2, 5, 6};
+
+	che * mesh = new che_off(vertices.data(), vertices.size(), faces.data(), faces.size() / che::P);
+	bool passed = test_laplacian(mesh);
+	delete mesh;
+
+	return passed;
+}
+
+bool test_batch_omp()
+{
+	const size_t K = 16, m = 32, n = 64, L = 10, n_patches = 100;
+
+	arma::arma_rng::set_seed(0);
+	a_mat A = arma::randn<a_mat>(K, m);
+
+	a_mat alpha(m, n_patches, arma::fill::zeros);
+	a_mat omp_alpha(m, n_patches, arma::fill::zeros);
+
+	mdict::omp_workspace ws(K, m, L);
+	for(index_t i = 0; i < n_patches; i++)
+	{
+		mdict::patch p;
+		p.xyz = arma::randn<a_mat>(3, n);
+		p.phi = arma::randn<a_mat>(n, K);
+
+		mdict::batch_OMP(alpha.colptr(i), A, p, L, ws);
+		mdict::OMP_patch(omp_alpha, A, i, p, L);
+	}
+
+	return norm(alpha - omp_alpha, "fro") <= 1e-8 * norm(omp_alpha, "fro");
+}
+
+
+bool test_ksvdt()
+{
+	const size_t K = 16, m = 32, n = 64, L = 4, n_patches = 300;
+
+	// patches of a dictionary A0 with random codes of 3 atoms
+	arma::arma_rng::set_seed(0);
+	a_mat A0 = arma::randn<a_mat>(K, m);
+
+	vector<mdict::patch> patches(n_patches);
+	for(mdict::patch & p: patches)
+	{
+		a_vec alpha(m, arma::fill::zeros);
+		alpha(arma::randi<arma::uvec>(3, arma::distr_param(0, m - 1))) = arma::randn<a_vec>(3);
+
+		p.phi = arma::randn<a_mat>(n, K);
+		p.xyz = arma::randn<a_mat>(3, n);
+		p.xyz.row(2) = (p.phi * A0 * alpha).t();
+	}
+
+	// squared residual of the patches coded with batch_OMP
+	auto residual = [&](const a_mat & A) -> real_t
+	{
+		real_t error = 0;
+		a_vec alpha(m);
+		mdict::omp_workspace ws(K, m, L);
+		for(const mdict::patch & p: patches)
+		{
+			mdict::batch_OMP(alpha.memptr(), A, p, L, ws);
+			error += accu(square(p.xyz.row(2).t() - p.phi * A * alpha));
+		}
+		return error;
+	};
+
+	a_mat A_start = A0 + 0.3 * arma::randn<a_mat>(K, m);
+
+	a_mat A = A_start;
+	mdict::KSVDT(A, patches, n_patches, L, 0, 5);
+
+	// the result must not depend on the number of threads
+	const int n_threads = omp_get_max_threads();
+	omp_set_num_threads(1);
+
+	a_mat A_serial = A_start;
+	mdict::KSVDT(A_serial, patches, n_patches, L, 0, 5);
+
+	omp_set_num_threads(n_threads);
+
+	return residual(A) < 0.5 * residual(A_start) && norm(A - A_serial, "fro") == 0;
+}
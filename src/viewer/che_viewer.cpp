@@ -181,7 +181,7 @@ void che_viewer::draw_normal_field()
 	for(index_t v = 0; v < _n_vertices; v++)
 	{
 		vertex n = factor * normals[v];
-		vertex a = mesh->get_vertex(v);
+		vertex a = mesh->gt(v);
 		vertex b = a + n;
 
 		glVertex3v(&a[0]);
@@ -300,6 +300,8 @@ void che_viewer::translate(const vertex & p)
 	#pragma omp parallel for
 	for(index_t v = 0; v < mesh->n_vertices(); v++)
 		mesh->get_vertex(v) += v_translate;
+
+	mesh->update_geometry();
 }
 
 void che_viewer::invert_orientation()
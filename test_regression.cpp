@@ -0,0 +1,7 @@
+#include "test_regression.h"
+
+int main(int nargs, const char ** args)
+{
+	return main_test_regression(nargs, args);
+}
+